@@ -1,6 +1,15 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
 #include "GSLfun.h"
 
-static gsl_rng* gslRNG;
+static GSLfun_RNG* gslRNG;
+static const gsl_rng_type* rngType;
+
+static void ziggurat_init();
 
 
 void Gauss_params_print( Gauss_params params ){
@@ -10,36 +19,723 @@ void Gauss_params_print( Gauss_params params ){
 void GSLfun_setup(){
   if(  !getenv( "GSL_RNG_SEED" )  )   printf(  "Using default random seed\n" );
   gsl_rng_env_setup();
-  gslRNG= gsl_rng_alloc(gsl_rng_mt19937);
+  if(  !rngType  )   rngType= gsl_rng_mt19937;
+  gslRNG= gsl_rng_alloc(rngType);
+  ziggurat_init();
+}
+
+
+/* ───────────  Philox4x32-10 counter based generator  ────────── */
+/*  Salmon et al. 2011, "Parallel random numbers: as easy as 1, 2, 3".
+ *  Output block number c of stream s under key k is a bijective scrambling of the 128 bit counter (c,s) by k,
+ *  so any output can be computed directly and streams never overlap.
+ *  Each block gives four 32 bit words.  The state is only the key, counter and current block.
+ */
+typedef struct{
+  uint32_t key[2];
+  uint32_t counter[4];   // Block number in counter[0..1], stream in counter[2..3]
+  uint32_t block[4];
+  uint index;            // Next word of block to return, 4 when it is used up
+} philox_state;
+
+static inline void philox4x32_10( const uint32_t counter[4], const uint32_t key[2], uint32_t out[4] ){
+  uint32_t c0= counter[0],  c1= counter[1],  c2= counter[2],  c3= counter[3];
+  uint32_t k0= key[0],  k1= key[1];
+  for(  uint round= 0;  round < 10;  ++round  ){
+    uint64_t p0=  (uint64_t) 0xD2511F53u * c0;
+    uint64_t p1=  (uint64_t) 0xCD9E8D57u * c2;
+    uint32_t n0=  (uint32_t) (p1 >> 32) ^ c1 ^ k0;
+    uint32_t n2=  (uint32_t) (p0 >> 32) ^ c3 ^ k1;
+    c0= n0;  c1= (uint32_t) p1;  c2= n2;  c3= (uint32_t) p0;
+    k0 += 0x9E3779B9u;  k1 += 0xBB67AE85u;
+  }
+  out[0]= c0;  out[1]= c1;  out[2]= c2;  out[3]= c3;
+}
+
+static void philox_init( philox_state* state, ulong seed, ulong stream ){
+  state->key[0]=  (uint32_t) seed;      state->key[1]=  (uint32_t) (seed >> 32);
+  state->counter[0]= 0;                 state->counter[1]= 0;
+  state->counter[2]=  (uint32_t) stream;  state->counter[3]=  (uint32_t) (stream >> 32);
+  state->index= 4;
+}
+
+static void philox_set( void* state, ulong seed ){
+  philox_init( state, seed, 0 );
+}
+
+static ulong philox_get( void* state_ptr ){
+  philox_state* state= state_ptr;
+  if(  state->index == 4  ){
+    philox4x32_10( state->counter, state->key, state->block );
+    if(  ++state->counter[0] == 0  )   ++state->counter[1];
+    state->index= 0;
+  }
+  return  state->block[state->index++];
+}
+
+static double philox_get_double( void* state ){
+  return  philox_get( state ) / 4294967296.0;
+}
+
+static const gsl_rng_type philox_type=
+  {"philox4x32-10", 0xFFFFFFFFUL, 0, sizeof(philox_state), philox_set, philox_get, philox_get_double};
+const gsl_rng_type* GSLfun_rng_philox= &philox_type;
+
+//  The next n words of rng, the same as n calls of gsl_rng_get.
+//  Philox fills whole blocks straight from their counters, in a loop the compiler can vectorize.
+static void rng_words_n( GSLfun_RNG* rng, uint32_t* out, size_t n ){
+  ulong (*get)(void*)=  rng->type->get;
+  void* state=  rng->state;
+  size_t i= 0;
+  if(  rng->type == GSLfun_rng_philox  ){
+    philox_state* philox= state;
+    for(  ;  i < n  &&  philox->index < 4;  ++i  )   out[i]=  get( state );
+    uint64_t block=  philox->counter[0]  |  (uint64_t) philox->counter[1] << 32;
+    size_t blocksN=  (n - i) / 4;
+    for(  size_t b= 0;  b < blocksN;  ++b  ){
+      uint64_t c=  block + b;
+      uint32_t counter[4]=  {(uint32_t) c,  (uint32_t) (c >> 32),  philox->counter[2],  philox->counter[3]};
+      philox4x32_10( counter, philox->key, out + i + 4*b );
+    }
+    i +=  4 * blocksN;
+    block +=  blocksN;
+    philox->counter[0]=  (uint32_t) block;
+    philox->counter[1]=  (uint32_t) (block >> 32);
+  }
+  for(  ;  i < n;  ++i  )   out[i]=  get( state );
+}
+
+//  Word n of stream under seed, the same as the n-th draw of GSLfun_RNG_alloc( stream ) with the philox generator.
+uint GSLfun_philox_word( ulong seed, ulong stream, ulong n ){
+  philox_state state;
+  philox_init( &state, seed, stream );
+  state.counter[0]=  (uint32_t) (n / 4);
+  state.counter[1]=  (uint32_t) (n / 4 >> 32);
+  philox4x32_10( state.counter, state.key, state.block );
+  return  state.block[n % 4];
+}
+
+//  Choose the generator by name, "mt19937" (the default) or "philox".  Call before GSLfun_setup.
+bool GSLfun_select_generator( const char* name ){
+  if(       !strcmp( name, "mt19937" )  )   rngType=  gsl_rng_mt19937;
+  else if(  !strcmp( name, "philox" )   )   rngType=  GSLfun_rng_philox;
+  else  return  false;
+  return  true;
+}
+
+
+/* ───────────  Generator contexts  ────────── */
+
+//  splitmix64 finalizer.  Scrambles x so that nearby inputs give unrelated outputs.
+static ulong bits_mix( ulong x ){
+  x= (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9UL;
+  x= (x ^ (x >> 27)) * 0x94D049BB133111EBUL;
+  return  x ^ (x >> 31);
 }
 
+//  Allocate an independent generator for numbered stream.
+//  Its sequence depends only on $GSL_RNG_SEED and stream, so parallel work split into streams is reproducible.
+//  Philox needs no mixing, since the stream is part of its counter.
+GSLfun_RNG* GSLfun_RNG_alloc( ulong stream ){
+  GSLfun_RNG* rng= gsl_rng_alloc(rngType);
+  if(  rngType == GSLfun_rng_philox  ){
+    philox_init( rng->state, gsl_rng_default_seed, stream );
+  }
+  else{
+    gsl_rng_set(  rng,  bits_mix( gsl_rng_default_seed + bits_mix(stream) )  );
+  }
+  return  rng;
+}
+
+void GSLfun_RNG_free( GSLfun_RNG* rng ){
+  gsl_rng_free( rng );
+}
+
+//  Write the name of rng's generator, then its state, in a form GSLfun_RNG_fread can restore.  Return 0 on success.
+int GSLfun_RNG_fwrite( FILE* file, const GSLfun_RNG* rng ){
+  if(  fprintf( file, "%s\n", gsl_rng_name( rng ) ) < 0  )   return  1;
+  return  gsl_rng_fwrite( file, rng );
+}
+
+//  Restore into rng a state written by GSLfun_RNG_fwrite.  Fails, returning nonzero, unless the generators match.
+int GSLfun_RNG_fread( FILE* file, GSLfun_RNG* rng ){
+  char name[64];
+  if(  !fgets( name, sizeof name, file )  )   return  1;
+  name[strcspn( name, "\n" )]=  '\0';
+  if(  strcmp( name, gsl_rng_name( rng ) )  )   return  1;
+  return  gsl_rng_fread( file, rng );
+}
+
+GSLfun_RNG* GSLfun_RNG_global(){
+  return  gslRNG;
+}
+
+//  Number for the child-th substream of stream parent.
+ulong GSLfun_stream_child( ulong parent, ulong child ){
+  return  bits_mix( parent + 0x9E3779B97F4A7C15UL * (child + 1) );
+}
+
+
+/* ───────────  Ziggurat Gaussian sampler  ────────── */
+/*  Doornik's ZIGNOR:  ZIG_LAYERS layers of equal area ZIG_V cover the right half of exp(-x²/2), the base layer
+ *  including the tail beyond ZIG_R.  A draw picks layer i and u ∈ (-1,1) and returns u·X[i] outright if
+ *  |u| < X[i+1]/X[i], about 99% of the time.  Otherwise it tests the wedge, or samples the tail, or starts over.
+ *  Each candidate takes one 32 bit word for u, and a quarter word for its layer.
+ */
+#define ZIG_LAYERS 128
+#define ZIG_R 3.442619855899
+#define ZIG_V 9.91256303526217e-3
+
+static double zigX[ZIG_LAYERS + 1];
+static double zigRatio[ZIG_LAYERS];
+
+static void ziggurat_init(){
+  double f=  exp( -0.5 * ZIG_R * ZIG_R );
+  zigX[0]=  ZIG_V / f;
+  zigX[1]=  ZIG_R;
+  zigX[ZIG_LAYERS]=  0.0;
+  for(  uint i= 2;  i < ZIG_LAYERS;  ++i  ){
+    zigX[i]=  sqrt( -2.0 * log( ZIG_V / zigX[i-1] + f ) );
+    f=  exp( -0.5 * zigX[i] * zigX[i] );
+  }
+  for(  uint i= 0;  i < ZIG_LAYERS;  ++i  )   zigRatio[i]=  zigX[i+1] / zigX[i];
+}
+
+//  Map a 32 bit word to u ∈ (-1,1), and to (0,1)
+static inline double ziggurat_u( uint32_t w ){
+  return  (w + 0.5) * 0x1p-31  -  1.0;
+}
+
+static inline double uniform_pos_of( uint32_t w ){
+  return  (w + 0.5) * 0x1p-32;
+}
+
+//  Finish a draw whose candidate u, layer i failed the fast test.
+static double ziggurat_slow( ulong (*get)(void*), void* state, double u, uint i ){
+  for(;;){
+    if(  fabs( u ) < zigRatio[i]  )   return  u * zigX[i];
+    if(  i == 0  ){
+      // Marsaglia's tail method, beyond ZIG_R
+      double x, y;
+      do{
+        x=  log( uniform_pos_of( get( state ) ) ) / ZIG_R;
+        y=  log( uniform_pos_of( get( state ) ) );
+      } while(  -2.0 * y  <  x * x  );
+      return  (u < 0.0)?  x - ZIG_R  :  ZIG_R - x;
+    }
+    double x=  u * zigX[i];
+    double f0=  exp( -0.5 * (zigX[i]   * zigX[i]   - x * x) );
+    double f1=  exp( -0.5 * (zigX[i+1] * zigX[i+1] - x * x) );
+    if(  f1  +  uniform_pos_of( get( state ) ) * (f0 - f1)  <  1.0  )   return  x;
+    u=  ziggurat_u( get( state ) );
+    i=  get( state ) & (ZIG_LAYERS-1);
+  }
+}
+
+//  A standard normal variate
+static double ziggurat_r( ulong (*get)(void*), void* state ){
+  double u=  ziggurat_u( get( state ) );
+  uint i=  get( state ) & (ZIG_LAYERS-1);
+  if(  fabs( u ) < zigRatio[i]  )   return  u * zigX[i];
+  return  ziggurat_slow( get, state, u, i );
+}
+
+#if defined(__AVX512F__)
+#define ZIG_VEC_N 8
+//  Fast test for 8 candidates:  store u·X[layer] in x, and return a bit mask of those accepted.
+static inline uint ziggurat_fast_vec( const double* u, const uint32_t* layer, double* x ){
+  __m512d u_v=  _mm512_loadu_pd( u );
+  __m256i i_v=  _mm256_loadu_si256( (const __m256i*) layer );
+  _mm512_storeu_pd(  x,  _mm512_mul_pd( u_v, _mm512_i32gather_pd( i_v, zigX, 8 ) )  );
+  return  _mm512_cmp_pd_mask( _mm512_abs_pd( u_v ), _mm512_i32gather_pd( i_v, zigRatio, 8 ), _CMP_LT_OQ );
+}
+#elif defined(__AVX2__)
+#define ZIG_VEC_N 4
+//  Fast test for 4 candidates, as above.
+static inline uint ziggurat_fast_vec( const double* u, const uint32_t* layer, double* x ){
+  __m256d u_v=  _mm256_loadu_pd( u );
+  __m128i i_v=  _mm_loadu_si128( (const __m128i*) layer );
+  _mm256_storeu_pd(  x,  _mm256_mul_pd( u_v, _mm256_i32gather_pd( zigX, i_v, 8 ) )  );
+  __m256d abs_u=  _mm256_andnot_pd( _mm256_set1_pd( -0.0 ), u_v );
+  return  _mm256_movemask_pd( _mm256_cmp_pd( abs_u, _mm256_i32gather_pd( zigRatio, i_v, 8 ), _CMP_LT_OQ ) );
+}
+#else
+#define ZIG_VEC_N 0
+#endif
+
+
+/* ───────────  Marsaglia-Tsang Gamma sampler  ────────── */
+/*  For shape a ≧ 1, with d= a-⅓ and c= 1/√(9d), a standard normal x gives the candidate d·(1+cx)³,
+ *  accepted with the squeeze  u < 1 - 0.0331x⁴  or else the full test  log u < ½x² + d(1 - v + log v),  v= (1+cx)³.
+ *  Shape a < 1 draws with shape a+1 and multiplies by u^(1/a).
+ *  Results are computed as logs, so the boost cannot underflow for small a.
+ */
+typedef struct{
+  double d;
+  double c;
+  double logScale;    // log( d θ )
+  double invShape;    // 1/a when boosting, else 0
+} gamma_sampler;
+
+static gamma_sampler gamma_sampler_make( double a, double theta ){
+  double boosted=  (a < 1.0)?  a + 1.0  :  a;
+  gamma_sampler sampler;
+  sampler.d=  boosted - 1.0/3.0;
+  sampler.c=  1.0 / sqrt( 9.0 * sampler.d );
+  sampler.logScale=  log( sampler.d * theta );
+  sampler.invShape=  (a < 1.0)?  1.0 / a  :  0.0;
+  return  sampler;
+}
+
+static inline bool gamma_accept( const gamma_sampler* sampler, double x, double v, double u ){
+  if(  v <= 0.0  )   return  false;
+  double xx=  x * x;
+  return  u  <  1.0 - 0.0331 * xx * xx   ||   log( u )  <  0.5 * xx  +  sampler->d * (1.0 - v + log( v ));
+}
+
+static double gamma_log_r( GSLfun_RNG* rng, const gamma_sampler* sampler ){
+  ulong (*get)(void*)=  rng->type->get;
+  void* state=  rng->state;
+  double x, v;
+  do{
+    x=  ziggurat_r( get, state );
+    double t=  1.0 + sampler->c * x;
+    v=  t * t * t;
+  } while(  !gamma_accept( sampler, x, v, uniform_pos_of( get( state ) ) )  );
+  double logX=  sampler->logScale + log( v );
+  if(  sampler->invShape  )   logX +=  log( uniform_pos_of( get( state ) ) ) * sampler->invShape;
+  return  logX;
+}
+
+//  Fill logOut[0..n-1] with logs of Gamma draws.  Candidates come in blocks of GAMMA_BLOCK,
+//  their normals from the batched ziggurat and their uniforms in bulk, with the cubes in a vectorizable loop.
+#define GAMMA_BLOCK 64
+static void gamma_log_n_r( GSLfun_RNG* rng, double* logOut, size_t n, double a, double theta ){
+  gamma_sampler sampler=  gamma_sampler_make( a, theta );
+  const Gauss_params standard= {0.0, 1.0};
+  double x[GAMMA_BLOCK],  v[GAMMA_BLOCK];
+  uint32_t words[GAMMA_BLOCK];
+  size_t i= 0;
+  while(  i < n  ){
+    size_t m=  (n - i < GAMMA_BLOCK)?  n - i  :  GAMMA_BLOCK;
+    GSLfun_ran_gaussian_n_r( rng, x, m, standard );
+    rng_words_n( rng, words, m );
+    for(  size_t j= 0;  j < m;  ++j  ){
+      double t=  1.0 + sampler.c * x[j];
+      v[j]=  t * t * t;
+    }
+    for(  size_t j= 0;  j < m;  ++j  ){
+      if(  gamma_accept( &sampler, x[j], v[j], uniform_pos_of( words[j] ) )  ){
+        logOut[i++]=  sampler.logScale + log( v[j] );
+      }
+    }
+  }
+  if(  sampler.invShape  ){
+    for(  i= 0;  i < n;  i += GAMMA_BLOCK  ){
+      size_t m=  (n - i < GAMMA_BLOCK)?  n - i  :  GAMMA_BLOCK;
+      rng_words_n( rng, words, m );
+      for(  size_t j= 0;  j < m;  ++j  ){
+        logOut[i+j] +=  log( uniform_pos_of( words[j] ) ) * sampler.invShape;
+      }
+    }
+  }
+}
+
+
+/* ───────────  Random variates drawn from a given context  ────────── */
+
+double GSLfun_ran_beta_r( GSLfun_RNG* rng, double a, double b ){
+  return  gsl_ran_beta( rng, a, b );
+}
+
+//  Beta(½,½) is the arcsine distribution, whose inverse CDF is sin²(πu/2).
+double GSLfun_ran_beta_Jeffreys_r( GSLfun_RNG* rng ){
+  double s=  sin(  M_PI_2 * uniform_pos_of( gsl_rng_get( rng ) )  );
+  return  s * s;
+}
+
+uint   GSLfun_ran_binomial_r( GSLfun_RNG* rng, double p, uint n ){
+  return  gsl_ran_binomial( rng, p, n );
+}
+
+double GSLfun_ran_gamma_r( GSLfun_RNG* rng, double a, double theta ){
+  gamma_sampler sampler=  gamma_sampler_make( a, theta );
+  return  exp( gamma_log_r( rng, &sampler ) );
+}
+
+double GSLfun_ran_gaussian_r( GSLfun_RNG* rng, Gauss_params params ){
+  return  params.mu + params.sigma * ziggurat_r( rng->type->get, rng->state );
+}
+
+//  Draw a fresh stream number, e.g. for seeding GSLfun_RNG_alloc.
+ulong  GSLfun_ran_stream_r( GSLfun_RNG* rng ){
+  return  gsl_rng_get( rng );
+}
+
+double gsl_ran_flat01_r( GSLfun_RNG* rng ){
+  return  gsl_ran_flat( rng, 0.0, 1.0 );
+}
+
+
+/* ───────────  Batches of random variates drawn from a given context  ────────── */
+
+void GSLfun_ran_beta_Jeffreys_n_r( GSLfun_RNG* rng, double* out, size_t n ){
+  uint32_t words[256];
+  for(  size_t begin= 0;  begin < n;  begin += 256  ){
+    size_t m=  (n - begin < 256)?  n - begin  :  256;
+    rng_words_n( rng, words, m );
+    for(  size_t j= 0;  j < m;  ++j  ){
+      double s=  sin(  M_PI_2 * uniform_pos_of( words[j] )  );
+      out[begin + j]=  s * s;
+    }
+  }
+}
+
+void GSLfun_ran_gamma_n_r( GSLfun_RNG* rng, double* out, size_t n, double a, double theta ){
+  gamma_log_n_r( rng, out, n, a, theta );
+  for(  size_t i= 0;  i < n;  ++i  )   out[i]=  exp( out[i] );
+}
+
+//  Draw precisions  τ ~ Γ(a,θ)  and write  σ= 1/√τ  to sigma,  and if not NULL,  1/σ  to invSigma and  log σ  to logSigma.
+void GSLfun_ran_gamma_sigma_n_r( GSLfun_RNG* rng, double* sigma, double* invSigma, double* logSigma, size_t n,
+                                 double a, double theta ){
+  double* logPrecision=  logSigma?  logSigma : sigma;
+  gamma_log_n_r( rng, logPrecision, n, a, theta );
+  for(  size_t i= 0;  i < n;  ++i  ){
+    double logPrec=  logPrecision[i];
+    double inv=  sqrt( exp( logPrec ) );
+    sigma[i]=  1.0 / inv;
+    if(  invSigma  )   invSigma[i]=  inv;
+    if(  logSigma  )   logSigma[i]=  -0.5 * logPrec;
+  }
+}
+
+//  Ziggurat in blocks of ZIG_BLOCK:  all the raw words first, then the fast test for ZIG_VEC_N at a time,
+//  then the rare rejects one by one.
+#define ZIG_BLOCK 64
+void GSLfun_ran_gaussian_n_r( GSLfun_RNG* rng, double* out, size_t n, Gauss_params params ){
+  ulong (*get)(void*)=  rng->type->get;
+  void* state=  rng->state;
+  double u[ZIG_BLOCK],  x[ZIG_BLOCK];
+  uint32_t words[ZIG_BLOCK + ZIG_BLOCK/4],  layer[ZIG_BLOCK];
+  for(  size_t begin= 0;  begin < n;  begin += ZIG_BLOCK  ){
+    size_t m=  (n - begin < ZIG_BLOCK)?  n - begin  :  ZIG_BLOCK;
+    size_t layerWordsN=  (m + 3) / 4;
+    rng_words_n( rng, words, m + layerWordsN );
+    for(  size_t j= 0;  j < m;  ++j  ){
+      u[j]=  ziggurat_u( words[j] );
+      layer[j]=  (words[m + j/4] >> (8 * (j%4))) & (ZIG_LAYERS-1);
+    }
+    uint64_t accepted= 0;
+    size_t j= 0;
+#if ZIG_VEC_N
+    for(  ;  j + ZIG_VEC_N <= m;  j += ZIG_VEC_N  ){
+      accepted |=  (uint64_t) ziggurat_fast_vec( u + j, layer + j, x + j ) << j;
+    }
+#endif
+    for(  ;  j < m;  ++j  ){
+      x[j]=  u[j] * zigX[layer[j]];
+      if(  fabs( u[j] ) < zigRatio[layer[j]]  )   accepted |=  (uint64_t) 1 << j;
+    }
+    for(  j= 0;  j < m;  ++j  ){
+      if(  !(accepted >> j & 1)  )   x[j]=  ziggurat_slow( get, state, u[j], layer[j] );
+      out[begin + j]=  params.mu  +  params.sigma * x[j];
+    }
+  }
+}
+
+//  Same values as repeated gsl_ran_flat01_r, minus a call and two pointer lookups per draw.
+void GSLfun_ran_flat01_n_r( GSLfun_RNG* rng, double* out, size_t n ){
+  double (*uniform)(void*)=  rng->type->get_double;
+  void* state=  rng->state;
+  size_t i= 0;
+  if(  rng->type == GSLfun_rng_philox  ){
+    uint32_t words[256];
+    for(  ;  i + 256 <= n;  i += 256  ){
+      rng_words_n( rng, words, 256 );
+      for(  uint w= 0;  w < 256;  ++w  )   out[i + w]=  words[w] / 4294967296.0;
+    }
+  }
+  for(  ;  i < n;  ++i  ){
+    out[i]=  uniform( state );
+  }
+}
+
+
+/* ───────────  Random variates drawn from the global context  ────────── */
 
 double GSLfun_ran_beta( double a, double b ){
-  return  gsl_ran_beta( gslRNG, a, b );
+  return  GSLfun_ran_beta_r( gslRNG, a, b );
 }
 
 double GSLfun_ran_beta_Jeffreys(){
-  return  gsl_ran_beta( gslRNG, 0.5, 0.5 );
+  return  GSLfun_ran_beta_Jeffreys_r( gslRNG );
 }
 
 uint   GSLfun_ran_binomial( double p, uint n ){
-  return  gsl_ran_binomial( gslRNG, p, n );
+  return  GSLfun_ran_binomial_r( gslRNG, p, n );
 }
 
 double GSLfun_ran_gamma( double a, double theta ){
-  return  gsl_ran_gamma( gslRNG, a, theta );
+  return  GSLfun_ran_gamma_r( gslRNG, a, theta );
 }
 
 double GSLfun_ran_gaussian( Gauss_params params ){
-  return  params.mu + gsl_ran_gaussian( gslRNG, params.sigma );
+  return  GSLfun_ran_gaussian_r( gslRNG, params );
+}
+
+ulong  GSLfun_ran_stream(){
+  return  GSLfun_ran_stream_r( gslRNG );
 }
 
+double gsl_ran_flat01(){
+  return  gsl_ran_flat01_r( gslRNG );
+}
+
+
+void GSLfun_ran_beta_Jeffreys_n( double* out, size_t n ){
+  GSLfun_ran_beta_Jeffreys_n_r( gslRNG, out, n );
+}
+
+void GSLfun_ran_gamma_n( double* out, size_t n, double a, double theta ){
+  GSLfun_ran_gamma_n_r( gslRNG, out, n, a, theta );
+}
+
+void GSLfun_ran_gamma_sigma_n( double* sigma, double* invSigma, double* logSigma, size_t n, double a, double theta ){
+  GSLfun_ran_gamma_sigma_n_r( gslRNG, sigma, invSigma, logSigma, n, a, theta );
+}
+
+void GSLfun_ran_gaussian_n( double* out, size_t n, Gauss_params params ){
+  GSLfun_ran_gaussian_n_r( gslRNG, out, n, params );
+}
+
+void GSLfun_ran_flat01_n( double* out, size_t n ){
+  GSLfun_ran_flat01_n_r( gslRNG, out, n );
+}
+
+
+/* ───────────  Densities  ────────── */
+
 double GSLfun_ran_gaussian_pdf( double x, Gauss_params params  ){
   return  gsl_ran_gaussian_pdf( x-params.mu, params.sigma );
 }
 
-double gsl_ran_flat01(){
-  return  gsl_ran_flat( gslRNG, 0.0, 1.0 );
+// Natural log of the Gaussian pdf, finite far into the tails where the pdf itself underflows.
+double GSLfun_ran_gaussian_logpdf( double x, Gauss_params params  ){
+  double z=  (x - params.mu) / params.sigma;
+  return  -0.5 * z * z  -  log( params.sigma * sqrt(2.0 * M_PI) );
+}
+
+double GSLfun_ran_gamma_logpdf( double x, double a, double theta ){
+  return  (a - 1.0) * log( x )  -  x / theta  -  gsl_sf_lngamma( a )  -  a * log( theta );
+}
+
+double GSLfun_ran_beta_logpdf( double x, double a, double b ){
+  return  (a - 1.0) * log( x )  +  (b - 1.0) * log1p( -x )
+    +     gsl_sf_lngamma( a + b )  -  gsl_sf_lngamma( a )  -  gsl_sf_lngamma( b );
+}
+
+
+
+/* ───────────  Densities of whole arrays  ────────── */
+/*
+ * The log density is  logNorm - ½((x-μ)·invSigma)²  with  invSigma= 1/σ  and  logNorm= -log(σ√2π)  computed once per call.
+ * The pdf is the exp of that, with exp evaluated as  2ᵏ·p(r)  for  x = k·ln2 + r,  |r| ≦ ½ln2,
+ * using the degree 13 Taylor polynomial p, whose truncation error is below one ulp.
+ * Values below e⁻⁷⁰⁰ are flushed to zero.
+ */
+#define EXP_UNDERFLOW -700.0
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+static const double exp_coef[14]=
+  {1.0, 1.0, 1/2.0, 1/6.0, 1/24.0, 1/120.0, 1/720.0, 1/5040.0, 1/40320.0, 1/362880.0, 1/3628800.0,
+   1/39916800.0, 1/479001600.0, 1/6227020800.0};
+static const double ln2_hi= 6.93147180369123816490e-01;
+static const double ln2_lo= 1.90821492927058770002e-10;
+#endif
+
+#if defined(__AVX512F__)
+#define GAUSS_VEC_N 8
+typedef  __m512d  vec_double;
+
+static inline vec_double logpdf_vec( vec_double x, vec_double mu, vec_double invSigma, vec_double logNorm ){
+  vec_double z=  _mm512_mul_pd( _mm512_sub_pd( x, mu ), invSigma );
+  return  _mm512_fmadd_pd( _mm512_mul_pd( z, z ), _mm512_set1_pd( -0.5 ), logNorm );
+}
+
+static inline vec_double exp_vec( vec_double x ){
+  __mmask8 underflow=  _mm512_cmp_pd_mask( x, _mm512_set1_pd( EXP_UNDERFLOW ), _CMP_LT_OQ );
+  x=  _mm512_max_pd( x, _mm512_set1_pd( EXP_UNDERFLOW ) );
+  vec_double k=  _mm512_roundscale_pd( _mm512_mul_pd( x, _mm512_set1_pd( M_LOG2E ) ),
+                                       _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC );
+  vec_double r=  _mm512_fnmadd_pd( k, _mm512_set1_pd( ln2_hi ), x );
+  r=  _mm512_fnmadd_pd( k, _mm512_set1_pd( ln2_lo ), r );
+  vec_double p=  _mm512_set1_pd( exp_coef[13] );
+  for(  int c= 12;  c >= 0;  --c  ){
+    p=  _mm512_fmadd_pd( p, r, _mm512_set1_pd( exp_coef[c] ) );
+  }
+  return  _mm512_maskz_scalef_pd( ~underflow, p, k );
+}
+#define vec_load   _mm512_loadu_pd
+#define vec_store  _mm512_storeu_pd
+#define vec_set1   _mm512_set1_pd
+#define vec_add    _mm512_add_pd
+#define vec_sum    _mm512_reduce_add_pd
+
+#elif defined(__AVX2__)
+#define GAUSS_VEC_N 4
+typedef  __m256d  vec_double;
+
+static inline vec_double logpdf_vec( vec_double x, vec_double mu, vec_double invSigma, vec_double logNorm ){
+  vec_double z=  _mm256_mul_pd( _mm256_sub_pd( x, mu ), invSigma );
+  return  _mm256_sub_pd( logNorm, _mm256_mul_pd( _mm256_mul_pd( z, z ), _mm256_set1_pd( 0.5 ) ) );
+}
+
+static inline vec_double exp_vec( vec_double x ){
+  vec_double underflow=  _mm256_cmp_pd( x, _mm256_set1_pd( EXP_UNDERFLOW ), _CMP_LT_OQ );
+  x=  _mm256_max_pd( x, _mm256_set1_pd( EXP_UNDERFLOW ) );
+  vec_double k=  _mm256_round_pd( _mm256_mul_pd( x, _mm256_set1_pd( M_LOG2E ) ),
+                                  _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC );
+  vec_double r=  _mm256_sub_pd( x, _mm256_mul_pd( k, _mm256_set1_pd( ln2_hi ) ) );
+  r=  _mm256_sub_pd( r, _mm256_mul_pd( k, _mm256_set1_pd( ln2_lo ) ) );
+  vec_double p=  _mm256_set1_pd( exp_coef[13] );
+  for(  int c= 12;  c >= 0;  --c  ){
+    p=  _mm256_add_pd( _mm256_mul_pd( p, r ), _mm256_set1_pd( exp_coef[c] ) );
+  }
+  // 2ᵏ by adding k to the exponent field of p.  Adding 1.5·2⁵² leaves integer k in the low mantissa bits.
+  const vec_double magic=  _mm256_set1_pd( 0x1.8p52 );
+  __m256i ki=  _mm256_sub_epi64( _mm256_castpd_si256( _mm256_add_pd( k, magic ) ), _mm256_castpd_si256( magic ) );
+  p=  _mm256_castsi256_pd( _mm256_add_epi64( _mm256_castpd_si256( p ), _mm256_slli_epi64( ki, 52 ) ) );
+  return  _mm256_andnot_pd( underflow, p );
+}
+
+static inline double vec_sum( vec_double v ){
+  __m128d half=  _mm_add_pd( _mm256_castpd256_pd128( v ), _mm256_extractf128_pd( v, 1 ) );
+  return  _mm_cvtsd_f64( _mm_add_sd( half, _mm_unpackhi_pd( half, half ) ) );
+}
+#define vec_load   _mm256_loadu_pd
+#define vec_store  _mm256_storeu_pd
+#define vec_set1   _mm256_set1_pd
+#define vec_add    _mm256_add_pd
+
+#else
+#define GAUSS_VEC_N 0
+#endif
+
+
+void GSLfun_ran_gaussian_logpdf_n( double* out, const double* x, size_t n, Gauss_params params ){
+  double invSigma=  1.0 / params.sigma;
+  double logNorm=  -log( params.sigma * sqrt(2.0 * M_PI) );
+  size_t i= 0;
+#if GAUSS_VEC_N
+  vec_double mu_v=  vec_set1( params.mu ),  invSigma_v=  vec_set1( invSigma ),  logNorm_v=  vec_set1( logNorm );
+  for(  ;  i + GAUSS_VEC_N <= n;  i += GAUSS_VEC_N  ){
+    vec_store(  out + i,  logpdf_vec( vec_load( x + i ), mu_v, invSigma_v, logNorm_v )  );
+  }
+#endif
+  for(  ;  i < n;  ++i  ){
+    double z=  (x[i] - params.mu) * invSigma;
+    out[i]=  logNorm  -  0.5 * z * z;
+  }
+}
+
+void GSLfun_ran_gaussian_pdf_n( double* out, const double* x, size_t n, Gauss_params params ){
+  GSLfun_ran_gaussian_pdf_n_inv( out, x, n, params.mu, 1.0 / params.sigma, log( params.sigma ) );
+}
+
+//  Same as GSLfun_ran_gaussian_pdf_n, for callers that already have 1/σ and log σ at hand.
+void GSLfun_ran_gaussian_pdf_n_inv( double* out, const double* x, size_t n,
+                                    double mu, double invSigma, double logSigma ){
+  double logNorm=  -logSigma  -  0.5 * log(2.0 * M_PI);
+  size_t i= 0;
+#if GAUSS_VEC_N
+  vec_double mu_v=  vec_set1( mu ),  invSigma_v=  vec_set1( invSigma ),  logNorm_v=  vec_set1( logNorm );
+  for(  ;  i + GAUSS_VEC_N <= n;  i += GAUSS_VEC_N  ){
+    vec_store(  out + i,  exp_vec( logpdf_vec( vec_load( x + i ), mu_v, invSigma_v, logNorm_v ) )  );
+  }
+#endif
+  for(  ;  i < n;  ++i  ){
+    double z=  (x[i] - mu) * invSigma;
+    double logpdf=  logNorm  -  0.5 * z * z;
+    out[i]=  (logpdf < EXP_UNDERFLOW)?  0.0  :  exp( logpdf );
+  }
+}
+
+double GSLfun_ran_gaussian_logpdf_sum( const double* x, size_t n, Gauss_params params ){
+  double invSigma=  1.0 / params.sigma;
+  double logNorm=  -log( params.sigma * sqrt(2.0 * M_PI) );
+  double sum= 0.0;
+  size_t i= 0;
+#if GAUSS_VEC_N
+  vec_double mu_v=  vec_set1( params.mu ),  invSigma_v=  vec_set1( invSigma ),  logNorm_v=  vec_set1( logNorm );
+  vec_double sum_v=  vec_set1( 0.0 );
+  for(  ;  i + GAUSS_VEC_N <= n;  i += GAUSS_VEC_N  ){
+    sum_v=  vec_add(  sum_v,  logpdf_vec( vec_load( x + i ), mu_v, invSigma_v, logNorm_v )  );
+  }
+  sum=  vec_sum( sum_v );
+#endif
+  for(  ;  i < n;  ++i  ){
+    double z=  (x[i] - params.mu) * invSigma;
+    sum +=  logNorm  -  0.5 * z * z;
+  }
+  return  sum;
+}
+
+
+/* ───────────  Sobol sequence  ────────── */
+
+// Primitive polynomial degree s, coefficients a and initial direction numbers m for dimensions 2...,
+// from Joe and Kuo's new-joe-kuo-6.21201 table.
+static const struct{ uint s, a, m[5]; }  sobolPolys[GSLfun_SOBOL_DIM_MAX - 1]= {
+  {1, 0, {1}},
+  {2, 1, {1, 3}},
+  {3, 1, {1, 3, 1}},
+  {3, 2, {1, 1, 1}},
+  {4, 1, {1, 1, 3, 3}},
+  {4, 4, {1, 3, 5, 13}},
+  {5, 2, {1, 1, 5, 5, 17}},
+};
+
+void GSLfun_sobol_shift_r( GSLfun_RNG* rng, uint* shift, uint dim ){
+  for(  uint d= 0;  d < dim;  ++d  )   shift[d]=  (uint) gsl_rng_uniform_int( rng, 0x10000 ) << 16
+                                          |  (uint) gsl_rng_uniform_int( rng, 0x10000 );
+}
+
+void GSLfun_sobol_init( GSLfun_sobol* sobol, uint dim, const uint* shift, ulong index ){
+  if(  dim > GSLfun_SOBOL_DIM_MAX  ){
+    fprintf( stderr, "GSLfun_sobol_init: dimension %u exceeds %u\n", dim, GSLfun_SOBOL_DIM_MAX );
+    exit( 70 );
+  }
+  sobol->dim=  dim;
+  sobol->index=  index;
+  for(  uint i= 0;  i < 32;  ++i  )   sobol->direction[0][i]=  1u << (31 - i);
+  for(  uint d= 1;  d < dim;  ++d  ){
+    uint s=  sobolPolys[d-1].s,  a=  sobolPolys[d-1].a;
+    uint* v=  sobol->direction[d];
+    for(  uint i= 0;  i < s;  ++i  )   v[i]=  sobolPolys[d-1].m[i] << (31 - i);
+    for(  uint i= s;  i < 32;  ++i  ){
+      v[i]=  v[i-s] ^ (v[i-s] >> s);
+      for(  uint k= 1;  k < s;  ++k  )   if(  (a >> (s-1-k)) & 1  )   v[i] ^=  v[i-k];
+    }
+  }
+  // Point index is the XOR of the direction numbers selected by the bits of its Gray code
+  ulong gray=  index ^ (index >> 1);
+  for(  uint d= 0;  d < dim;  ++d  ){
+    sobol->shift[d]=  shift[d];
+    sobol->x[d]=  0;
+    for(  uint i= 0;  i < 32;  ++i  )   if(  (gray >> i) & 1  )   sobol->x[d] ^=  sobol->direction[d][i];
+  }
+}
+
+void GSLfun_sobol_next( GSLfun_sobol* sobol, double* u ){
+  for(  uint d= 0;  d < sobol->dim;  ++d  ){
+    u[d]=  ((sobol->x[d] ^ sobol->shift[d])  +  0.5)  *  0x1p-32;
+  }
+  // Consecutive Gray codes differ in the bit of the lowest zero bit of index
+  uint c= 0;
+  for(  ulong i= sobol->index;  i & 1;  i >>= 1  )   ++c;
+  for(  uint d= 0;  d < sobol->dim;  ++d  )   sobol->x[d] ^=  sobol->direction[d][c];
+  ++sobol->index;
 }
 
 
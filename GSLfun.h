@@ -1,13 +1,17 @@
 #pragma once
 #include <math.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <gsl/gsl_cdf.h>
+#include <gsl/gsl_errno.h>
+#include <gsl/gsl_integration.h>
 #include <gsl/gsl_rng.h>
 #include <gsl/gsl_randist.h>
 #include <gsl/gsl_sf_gamma.h>
 
 
-typedef  unsigned int  uint;
+typedef  unsigned int   uint;
+typedef  unsigned long  ulong;
 
 typedef struct{
   double mu;
@@ -18,14 +22,94 @@ void Gauss_params_print( Gauss_params params );
 
 void GSLfun_setup();
 
+
+/* Random number generator context.
+ * The *_r functions draw from the context they are given, so they may be called
+ * concurrently as long as each thread uses its own context.
+ * The functions without _r draw from the global context set up by GSLfun_setup().
+ */
+typedef  gsl_rng  GSLfun_RNG;
+
+bool        GSLfun_select_generator( const char* name );
+GSLfun_RNG* GSLfun_RNG_alloc( ulong stream );
+void        GSLfun_RNG_free( GSLfun_RNG* rng );
+int         GSLfun_RNG_fwrite( FILE* file, const GSLfun_RNG* rng );
+int         GSLfun_RNG_fread( FILE* file, GSLfun_RNG* rng );
+GSLfun_RNG* GSLfun_RNG_global();
+ulong       GSLfun_stream_child( ulong parent, ulong child );
+
+/* Philox4x32-10, a counter based generator usable as a gsl_rng_type.
+ * Its n-th 32 bit word for any (seed, stream, n) can be computed directly.
+ */
+extern const gsl_rng_type* GSLfun_rng_philox;
+uint GSLfun_philox_word( ulong seed, ulong stream, ulong n );
+
+double GSLfun_ran_beta_r( GSLfun_RNG* rng, double a, double b );
+double GSLfun_ran_beta_Jeffreys_r( GSLfun_RNG* rng );
+uint   GSLfun_ran_binomial_r( GSLfun_RNG* rng, double p, uint n );
+double GSLfun_ran_gamma_r( GSLfun_RNG* rng, double a, double theta );
+double GSLfun_ran_gaussian_r( GSLfun_RNG* rng, Gauss_params params );
+ulong  GSLfun_ran_stream_r( GSLfun_RNG* rng );
+double gsl_ran_flat01_r( GSLfun_RNG* rng );
+
+/* Batch versions.  Fill out[0..n-1] with independent draws.
+ * Gaussian draws, single or batched, use a ziggurat whose tables GSLfun_setup() builds;
+ * the batch version tests candidates with AVX-512 or AVX2 when compiled for them.
+ * Gamma draws use Marsaglia and Tsang's method on top of it.
+ * GSLfun_ran_gamma_sigma_n_r draws precisions τ but writes σ= 1/√τ, optionally with 1/σ and log σ (either may be NULL).
+ */
+void   GSLfun_ran_beta_Jeffreys_n_r( GSLfun_RNG* rng, double* out, size_t n );
+void   GSLfun_ran_gamma_n_r( GSLfun_RNG* rng, double* out, size_t n, double a, double theta );
+void   GSLfun_ran_gamma_sigma_n_r( GSLfun_RNG* rng, double* sigma, double* invSigma, double* logSigma, size_t n,
+                                   double a, double theta );
+void   GSLfun_ran_gaussian_n_r( GSLfun_RNG* rng, double* out, size_t n, Gauss_params params );
+void   GSLfun_ran_flat01_n_r( GSLfun_RNG* rng, double* out, size_t n );
+
 double GSLfun_ran_beta( double a, double b );
 double GSLfun_ran_beta_Jeffreys();
 uint   GSLfun_ran_binomial( double p, uint n );
 double GSLfun_ran_gamma( double a, double theta );
 double GSLfun_ran_gaussian( Gauss_params params );
+ulong  GSLfun_ran_stream();
+double gsl_ran_flat01();
+
+void   GSLfun_ran_beta_Jeffreys_n( double* out, size_t n );
+void   GSLfun_ran_gamma_n( double* out, size_t n, double a, double theta );
+void   GSLfun_ran_gamma_sigma_n( double* sigma, double* invSigma, double* logSigma, size_t n, double a, double theta );
+void   GSLfun_ran_gaussian_n( double* out, size_t n, Gauss_params params );
+void   GSLfun_ran_flat01_n( double* out, size_t n );
+
 double GSLfun_ran_gaussian_pdf( double x, Gauss_params params );
+double GSLfun_ran_gaussian_logpdf( double x, Gauss_params params );
+double GSLfun_ran_gamma_logpdf( double x, double a, double theta );
+double GSLfun_ran_beta_logpdf( double x, double a, double b );
 
-double gsl_ran_flat01();
+/* Densities of x[0..n-1], vectorized with AVX-512 or AVX2 when compiled for them. */
+void   GSLfun_ran_gaussian_pdf_n( double* out, const double* x, size_t n, Gauss_params params );
+void   GSLfun_ran_gaussian_pdf_n_inv( double* out, const double* x, size_t n,
+                                      double mu, double invSigma, double logSigma );
+void   GSLfun_ran_gaussian_logpdf_n( double* out, const double* x, size_t n, Gauss_params params );
+double GSLfun_ran_gaussian_logpdf_sum( const double* x, size_t n, Gauss_params params );
+
+
+/* Sobol low discrepancy sequence in up to GSLfun_SOBOL_DIM_MAX dimensions, in Gray code order,
+ * with a random digital shift (each coordinate's bits XORed with a random word) so that estimates are unbiased.
+ * A sequence may start at any index, so chunks of one sequence can be generated independently.
+ * Coordinates lie strictly inside (0,1), so they may be passed to inverse CDFs.
+ */
+#define GSLfun_SOBOL_DIM_MAX 8
+
+typedef struct{
+  uint dim;
+  ulong index;                               // Index of the next point
+  uint x[GSLfun_SOBOL_DIM_MAX];              // Next point before shifting, as 32 bit binary fractions
+  uint shift[GSLfun_SOBOL_DIM_MAX];
+  uint direction[GSLfun_SOBOL_DIM_MAX][32];
+} GSLfun_sobol;
+
+void GSLfun_sobol_shift_r( GSLfun_RNG* rng, uint* shift, uint dim );
+void GSLfun_sobol_init( GSLfun_sobol* sobol, uint dim, const uint* shift, ulong index );
+void GSLfun_sobol_next( GSLfun_sobol* sobol, double* u );
 
 
 double sigma_of_precision( double precision );
@@ -6,19 +6,21 @@
  *  Licence: GPLv3
  *  Description: Simple demonstration of a Bayesian way to guess at the number of components
  *               behind a sample of numerical data.
- *  Compile:  gcc -O3 -o Gaussian_poolOrNot Gaussian_poolOrNot.c GSLfun.c -lgsl -lgslcblas -lm
+ *  Compile:  gcc -O3 -march=native -pthread -o Gaussian_poolOrNot Gaussian_poolOrNot.c GSLfun.c -lgsl -lgslcblas -lm
  *  Environment: $GSL_RNG_SEED
  */
 #include <assert.h>
 #include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
 #include "GSLfun.h"
 /* ───────────  Global definitions and variables  ────────── */
-#define DATA_N 40
-#define CDF_GAUSS_N 20
-#define CDF_GAMMA_N 10
-#define CDF_JBETA_N 40
 
 typedef struct{
   double mixCof;
@@ -26,39 +28,143 @@ typedef struct{
   Gauss_params Gauss2;
 } Gauss_mixture_params;
 
+// Batches of parameters as structures of arrays, each array 64-byte aligned.
+// 1/σ and log σ are kept alongside σ, so likelihood kernels need not recompute them.
+typedef struct{
+  uint n;
+  double* mu;
+  double* sigma;
+  double* invSigma;
+  double* logSigma;
+} Gauss_params_batch;
+
+typedef struct{
+  uint n;
+  double* mixCof;
+  Gauss_params_batch Gauss1;
+  Gauss_params_batch Gauss2;
+} Gauss_mixture_params_batch;
+
 
 const Gauss_params mu_prior_params= {0.0, 4.0};
 const double sigma_prior_param_a= 0.5;
 const double sigma_prior_param_b= 2.0;
 
 
-double data[DATA_N];
-const uint dataN= DATA_N;
+// One sample of numerical data
+typedef struct{
+  double* x;
+  uint n;
+} Dataset;
+
+// Run configuration, settable from the command line
+uint dataN= 40;
+uint cdf_Gauss_n= 20;
+uint cdf_gamma_n= 10;
+uint cdf_JBeta_n= 40;
+uint quad_nodes_n= 6;
+double pruneTolerance= 1e-6;   // Relative error allowed from skipping negligible terms in the Riemann sums
 
 enum modelNames{ POOLED, DIFFER };
 
-const uint sampleRepeatNum= 2000000;
+uint sampleRepeatNum= 2000000;  // Most samples to use in each prior sampling integral
+
+// Sampling integrators stop early once the relative standard error of their estimate falls to sampleTolerance,
+// or after sampleTimeBudget seconds for one integral.  Either is off when zero.
+double sampleTolerance= 0.0;
+double sampleTimeBudget= 0.0;
+const uint sampleMinChunks= 4;  // Do not trust the standard error estimated from fewer chunks than this
+
+// Sampling integrators split their work into chunks of at most this many samples, each with its own RNG stream;
+// integrals of fewer samples use smaller chunks, so that there are at least sampleMinChunks² of them to stop between.
+// Results depend on the chunk size but not on the number of threads.
+const uint sampleChunkSize= 8192;
+
+// Roots of the RNG stream numbers, so that streams used for different purposes never coincide
+enum streamRoots{ STREAM_PRIOR_BANK= 0, STREAM_DATA_1COMPONENT= 1, STREAM_DATA_2COMPONENT= 2 };
+
+uint threadsN= 1;            // Threads to use in total
+uint integratorThreadsN= 1;  // Threads each integrator call may use
+
+
+
+/* ───────────  Memory allocation  ────────── */
+
+// Alignment of arrays of doubles, enough for any SIMD load.
+#define DOUBLES_ALIGN 64
+
+//  Number of doubles to reserve for n, rounded up to fill whole aligned blocks.
+size_t doubles_padded( size_t n ){
+  const size_t block=  DOUBLES_ALIGN / sizeof(double);
+  return  (n + block - 1) / block * block;
+}
+
+//  Allocate an aligned array of n doubles.  Exits on failure.
+double* doubles_alloc( size_t n ){
+  double* array=  aligned_alloc(  DOUBLES_ALIGN,  doubles_padded( n ? n : 1 ) * sizeof(double)  );
+  if(  !array  ){
+    fprintf(  stderr, "Failed to allocate %zu doubles\n", n  );
+    exit( 71 );
+  }
+  return  array;
+}
 
 
 
 /* ───────────  Functions to help summarize or dump the data  ────────── */
 
-double data_sample_mean(){
+double data_sample_mean( const Dataset* data ){
   double mean= 0.0;
-  for( uint i= 0;  i < dataN;  ++i ){
-    mean += data[i];
+  for( uint i= 0;  i < data->n;  ++i ){
+    mean += data->x[i];
   }
-  return  mean / (double) dataN;
+  return  mean / (double) data->n;
 }
 
-double data_sample_variance(){
-  double mean= data_sample_mean();
+double data_sample_variance( const Dataset* data ){
+  double mean= data_sample_mean( data );
   double var= 0.0;
-  for( uint i= 0;  i < dataN;  ++i ){
-    double diff=  data[i] - mean;
+  for( uint i= 0;  i < data->n;  ++i ){
+    double diff=  data->x[i] - mean;
     var +=  diff * diff;
   }
-  return  var / (double) (dataN);
+  return  var / (double) (data->n);
+}
+
+
+// Sufficient statistics of the data for a single Gaussian
+typedef struct{
+  uint n;
+  double mean;
+  double sumSqDev;  // Σ (x - mean)²
+} data_summary;
+
+data_summary data_summarize( const Dataset* data ){
+  data_summary summary=  {data->n,  data_sample_mean( data ),  data->n * data_sample_variance( data )};
+  return  summary;
+}
+
+//  log P[D|μ,σ] for a single Gaussian, in O(1) time from the sufficient statistics of D.
+double data_summary_logLikelihood( const data_summary* summary, Gauss_params params ){
+  double n= summary->n;
+  double diff=  summary->mean - params.mu;
+  return  -n * log( params.sigma * sqrt(2.0 * M_PI) )
+    -     (summary->sumSqDev  +  n * diff * diff) / (2.0 * params.sigma * params.sigma);
+}
+
+//  data_summary_logLikelihood for parameters begin...begin+n-1 of batch, written to out[0..n-1].
+void data_summary_logLikelihood_batch( double* out, const data_summary* summary,
+                                       const Gauss_params_batch* batch, uint begin, uint n ){
+  const double dataN_d=  summary->n;
+  const double logNorm=  0.5 * dataN_d * log(2.0 * M_PI);
+  const double* mu=        batch->mu + begin;
+  const double* invSigma=  batch->invSigma + begin;
+  const double* logSigma=  batch->logSigma + begin;
+  for(  uint i= 0;  i < n;  ++i  ){
+    double diff=  summary->mean - mu[i];
+    out[i]=  -dataN_d * logSigma[i]  -  logNorm
+      -      0.5 * (summary->sumSqDev  +  dataN_d * diff * diff) * invSigma[i] * invSigma[i];
+  }
 }
 
 
@@ -70,57 +176,295 @@ int CMPdata( const void *arg1, const void *arg2 ){
          /* else    *arg1 == *arg2   */        0);
 }
 
-void data_print(){
-  qsort(  data,  dataN,  sizeof(double), CMPdata  );
-  for( uint i= 0;  i < dataN;  ++i ){
-    printf( "%+5.3f ", i, data[i] );
+void data_print( Dataset* data ){
+  qsort(  data->x,  data->n,  sizeof(double), CMPdata  );
+  for( uint i= 0;  i < data->n;  ++i ){
+    printf( "%+5.3f ", data->x[i] );
   }
 }
 
 
 /* ───────────  Functions used for sampling/generating data   ────────── */
 
-Gauss_params prior_Gauss_params_sample(){
+Gauss_params prior_Gauss_params_sample_r( GSLfun_RNG* rng ){
   Gauss_params params;
-  params.mu=   GSLfun_ran_gaussian( mu_prior_params );
-  params.sigma=  sigma_of_precision( GSLfun_ran_gamma(sigma_prior_param_a, sigma_prior_param_b) );
+  params.mu=   GSLfun_ran_gaussian_r( rng, mu_prior_params );
+  params.sigma=  sigma_of_precision( GSLfun_ran_gamma_r(rng, sigma_prior_param_a, sigma_prior_param_b) );
   return  params;
 }
 
 
-Gauss_mixture_params prior_Gauss_mixture_params_sample(){
+Gauss_mixture_params prior_Gauss_mixture_params_sample_r( GSLfun_RNG* rng ){
   Gauss_mixture_params params;
-  params.mixCof=  GSLfun_ran_beta_Jeffreys();
-  params.Gauss1=  prior_Gauss_params_sample();
-  params.Gauss2=  prior_Gauss_params_sample();
+  params.mixCof=  GSLfun_ran_beta_Jeffreys_r( rng );
+  params.Gauss1=  prior_Gauss_params_sample_r( rng );
+  params.Gauss2=  prior_Gauss_params_sample_r( rng );
   return  params;
 }
 
-void data_generate_1component( Gauss_params params ){
-  for( uint i= 0; i < dataN; ++i ){
-    data[i]=  GSLfun_ran_gaussian( params );
+
+Gauss_params_batch Gauss_params_batch_alloc( uint n ){
+  Gauss_params_batch batch=  {n, doubles_alloc( n ), doubles_alloc( n ), doubles_alloc( n ), doubles_alloc( n )};
+  return  batch;
+}
+
+void Gauss_params_batch_free( Gauss_params_batch* batch ){
+  free( batch->mu );
+  free( batch->sigma );
+  free( batch->invSigma );
+  free( batch->logSigma );
+}
+
+Gauss_mixture_params_batch Gauss_mixture_params_batch_alloc( uint n ){
+  Gauss_mixture_params_batch batch=  {n, doubles_alloc( n ), Gauss_params_batch_alloc( n ), Gauss_params_batch_alloc( n )};
+  return  batch;
+}
+
+void Gauss_mixture_params_batch_free( Gauss_mixture_params_batch* batch ){
+  free( batch->mixCof );
+  Gauss_params_batch_free( &batch->Gauss1 );
+  Gauss_params_batch_free( &batch->Gauss2 );
+}
+
+
+//  Fill entries begin...begin+n-1 of batch with samples from the prior.
+void prior_Gauss_params_sample_batch_r( GSLfun_RNG* rng, Gauss_params_batch* batch, uint begin, uint n ){
+  GSLfun_ran_gaussian_n_r( rng, batch->mu + begin, n, mu_prior_params );
+  GSLfun_ran_gamma_sigma_n_r( rng, batch->sigma + begin, batch->invSigma + begin, batch->logSigma + begin, n,
+                              sigma_prior_param_a, sigma_prior_param_b );
+}
+
+void prior_Gauss_mixture_params_sample_batch_r( GSLfun_RNG* rng, Gauss_mixture_params_batch* batch, uint begin, uint n ){
+  GSLfun_ran_beta_Jeffreys_n_r( rng, batch->mixCof + begin, n );
+  prior_Gauss_params_sample_batch_r( rng, &batch->Gauss1, begin, n );
+  prior_Gauss_params_sample_batch_r( rng, &batch->Gauss2, begin, n );
+}
+
+
+void data_generate_1component( Dataset* data, GSLfun_RNG* rng, Gauss_params params ){
+  GSLfun_ran_gaussian_n_r( rng, data->x, data->n, params );
+}
+
+void data_generate_2component( Dataset* data, GSLfun_RNG* rng, Gauss_mixture_params params ){
+  const Gauss_params standard= {0.0, 1.0};
+  double* component_u=  doubles_alloc( data->n );
+  GSLfun_ran_flat01_n_r( rng, component_u, data->n );
+  GSLfun_ran_gaussian_n_r( rng, data->x, data->n, standard );
+  for( uint i= 0; i < data->n; ++i ){
+    Gauss_params component=  (component_u[i] < params.mixCof)?  params.Gauss1  : params.Gauss2;
+    data->x[i]=  component.mu  +  component.sigma * data->x[i];
+  }
+  free( component_u );
+}
+
+
+/* ───────────  Log-space accumulation  ────────── */
+
+// Sum of terms given by their logs, held as  exp(max) × sum  so that it never underflows.
+typedef struct{
+  double max;
+  double sum;
+} LogSumExp;
+
+const LogSumExp LogSumExp_empty= {-INFINITY, 0.0};
+
+void LogSumExp_merge( LogSumExp* acc, LogSumExp other ){
+  if(  other.sum == 0.0  )   return;
+  if(  other.max <= acc->max  ){
+    acc->sum +=  other.sum * exp( other.max - acc->max );
+  }
+  else{
+    acc->sum=  acc->sum * exp( acc->max - other.max )  +  other.sum;
+    acc->max=  other.max;
+  }
+}
+
+void LogSumExp_add( LogSumExp* acc, double logX ){
+  if(  logX == -INFINITY  )   return;
+  if(  logX <= acc->max  ){
+    acc->sum +=  exp( logX - acc->max );
+  }
+  else{
+    acc->sum=  acc->sum * exp( acc->max - logX )  +  1.0;
+    acc->max=  logX;
+  }
+}
+
+double LogSumExp_log( LogSumExp acc ){
+  return  acc.max + log( acc.sum );
+}
+
+
+// Running count, sum and sum of squares of Monte Carlo terms wᵢ, the latter two as LogSumExp of log wᵢ and 2 log wᵢ.
+// Like Welford's running mean and variance, but in log space so terms like exp(-700) neither underflow nor lose precision.
+typedef struct{
+  ulong n;
+  LogSumExp sum;
+  LogSumExp sumSq;
+} LogMoments;
+
+const LogMoments LogMoments_empty= {0, {-INFINITY, 0.0}, {-INFINITY, 0.0}};
+
+void LogMoments_add( LogMoments* acc, double logX ){
+  ++acc->n;
+  LogSumExp_add( &acc->sum,    logX );
+  LogSumExp_add( &acc->sumSq,  2.0 * logX );
+}
+
+void LogMoments_merge( LogMoments* acc, LogMoments other ){
+  acc->n += other.n;
+  LogSumExp_merge( &acc->sum,    other.sum );
+  LogSumExp_merge( &acc->sumSq,  other.sumSq );
+}
+
+//  log of the mean of the terms
+double LogMoments_logMean( LogMoments acc ){
+  return  LogSumExp_log( acc.sum ) - log( acc.n );
+}
+
+//  Standard error of the mean of the terms, relative to the mean; about the standard error of LogMoments_logMean.
+double LogMoments_relStdErr( LogMoments acc ){
+  if(  acc.n < 2  ||  acc.sum.sum == 0.0  )   return  INFINITY;
+  //  n Σw² / (Σw)²  =  1  +  (n-1)/n × sample variance / mean²
+  double ratio=  exp(  LogSumExp_log( acc.sumSq ) + log( acc.n )  -  2.0 * LogSumExp_log( acc.sum )  );
+  return  sqrt(  fmax( ratio - 1.0, 0.0 ) / (acc.n - 1)  );
+}
+
+
+//  Multiply *prod by x, moving powers of two into *expo whenever *prod drifts far from 1.
+//  Used for products of mixture densities, which are not cheap to take logs of term by term.
+//  A factor far from 1 is normalized first, so that with *prod kept within 2^±500 the product never under- or overflows.
+static inline void scaledProd_mul( double* prod, int* expo, double x ){
+  if(  x < 0x1p-500  ||  x > 0x1p500  ){
+    int e;
+    x=  frexp( x, &e );
+    *expo += e;
+  }
+  *prod *= x;
+  if(  *prod < 0x1p-500  ||  *prod > 0x1p500  ){
+    int e;
+    *prod=  frexp( *prod, &e );
+    *expo += e;
+  }
+}
+
+double scaledProd_log( double prod, int expo ){
+  return  log( prod )  +  expo * M_LN2;
+}
+
+
+
+/* ───────────  Parallel loop helper  ────────── */
+
+typedef struct{
+  void (*body)( uint i, void* arg );
+  void* arg;
+  uint n;
+  atomic_uint next;
+} parallel_for_job;
+
+void* parallel_for_worker( void* job_ptr ){
+  parallel_for_job* job= job_ptr;
+  for(  uint i;  (i= atomic_fetch_add( &job->next, 1 )) < job->n;  ){
+    job->body( i, job->arg );
   }
+  return  NULL;
 }
 
-void data_generate_2component( Gauss_mixture_params params ){
-  for( uint i= 0; i < dataN; ++i ){
-    data[i]=  GSLfun_ran_gaussian
-      (gsl_ran_flat01() < params.mixCof?  params.Gauss1  : params.Gauss2);
+//  Call body(i,arg) for i ∈ [0,n), spread over up to threads_n threads in no particular order.
+void parallel_for( uint n, uint threads_n, void (*body)( uint i, void* arg ), void* arg ){
+  parallel_for_job job=  {body, arg, n, 0};
+  uint workersN=  (threads_n < n)?  threads_n : n;
+  pthread_t workers[workersN];
+
+  // The calling thread does its share as well
+  for(  uint t= 1;  t < workersN;  ++t  ){
+    if(  pthread_create( &workers[t], NULL, parallel_for_worker, &job )  ){
+      perror( "pthread_create" );
+      exit( 71 );
+    }
   }
+  parallel_for_worker( &job );
+  for(  uint t= 1;  t < workersN;  ++t  ){
+    pthread_join( workers[t], NULL );
+  }
+}
+
+
+
+/* ───────────  Prior samples shared by all datasets  ────────── */
+
+// When not NULL, the sampling integrators use these samples instead of drawing their own.
+// The single component model uses the Gauss1 part.
+Gauss_mixture_params_batch* priorBank= NULL;
+
+
+void prior_sample_bank_fill_chunk( uint chunk, void* bank_ptr ){
+  Gauss_mixture_params_batch* bank= bank_ptr;
+  GSLfun_RNG* rng=  GSLfun_RNG_alloc(  GSLfun_stream_child( STREAM_PRIOR_BANK, chunk )  );
+  uint begin=  chunk * sampleChunkSize;
+  uint n=  (begin + sampleChunkSize > bank->n)?  bank->n - begin : sampleChunkSize;
+  prior_Gauss_mixture_params_sample_batch_r( rng, bank, begin, n );
+  GSLfun_RNG_free( rng );
+}
+
+//  Draw a bank of n prior samples, in parallel chunks of sampleChunkSize.
+Gauss_mixture_params_batch* prior_sample_bank_alloc( uint n ){
+  Gauss_mixture_params_batch* bank=  malloc( sizeof(Gauss_mixture_params_batch) );
+  *bank=  Gauss_mixture_params_batch_alloc( n );
+  parallel_for(  (n + sampleChunkSize - 1) / sampleChunkSize,  threadsN,  prior_sample_bank_fill_chunk,  bank  );
+  return  bank;
+}
+
+void prior_sample_bank_free( Gauss_mixture_params_batch* bank ){
+  Gauss_mixture_params_batch_free( bank );
+  free( bank );
 }
 
 
+
 /* ───────────  Functions used for numerical integration  ────────── */
 
-// Arrays to hold precomputed values.
-double cdfInv_Gauss[CDF_GAUSS_N];  const double cdf_Gauss_n= CDF_GAUSS_N;
-double cdfInv_gamma[CDF_GAMMA_N];  const double cdf_gamma_n= CDF_GAMMA_N;
-double cdfInv_JBeta[CDF_JBETA_N];  const double cdf_JBeta_n= CDF_JBETA_N;
+// A rule for integrating over the prior as a weighted sum over a list of nodes (μ, precision) for each component,
+// and a list of mixCof values with weights summing to 1.
+// The component weights include the prior density divided by the density the nodes were placed by, so the
+// rule approximates  ∫ P[μ,σ] f(μ,σ)  by  Σ_c exp(logWeight[c]) f(μ_c,σ_c).
+// The mixCof nodes are ≦ ½.  By symmetry each also stands for 1-mixCof, with the components swapped.
+typedef struct{
+  uint components_n;
+  double* mu;
+  double* sigma;
+  double* logWeight;
+  uint JBeta_n;
+  double* JBeta;
+  double* JBetaWeight;
+} prior_rule;
+
+prior_rule quantileRule;    // Equally weighted prior quantiles, on a cdf_Gauss_n × cdf_gamma_n grid and cdf_JBeta_n mixCof values
 
-//  Precompute the cumulative probabilities of μ and σ discrete values.
-//  The probabilities depend on the current prior_params values
-void cdfInv_precompute(){
+void prior_rule_alloc( prior_rule* rule, uint components_n, uint JBeta_n ){
+  rule->components_n=  components_n;
+  rule->mu=  doubles_alloc( components_n );
+  rule->sigma=  doubles_alloc( components_n );
+  rule->logWeight=  doubles_alloc( components_n );
+  rule->JBeta_n=  JBeta_n;
+  rule->JBeta=  doubles_alloc( JBeta_n );
+  rule->JBetaWeight=  doubles_alloc( JBeta_n );
+}
+
+void prior_rule_free( prior_rule* rule ){
+  free( rule->mu );  free( rule->sigma );  free( rule->logWeight );
+  free( rule->JBeta );  free( rule->JBetaWeight );
+}
+
+
+//  Allocate *rule and fill it with the prior quantiles on a Gauss_n × gamma_n grid, and JBeta_n mixCof values.
+//  The quantiles depend on the current prior_params values
+void prior_rule_quantiles( prior_rule* rule, uint cdf_Gauss_n, uint cdf_gamma_n, uint cdf_JBeta_n ){
   double x;
+  double* cdfInv_Gauss=  doubles_alloc( cdf_Gauss_n );
+  double* cdfInv_gamma=  doubles_alloc( cdf_gamma_n );
+  prior_rule_alloc( rule, cdf_Gauss_n * cdf_gamma_n, cdf_JBeta_n );
   // Since Normal range is unbounded, precompute cdfInv for vals:  ¹⁄₍ₙ₊₁₎...ⁿ⁄₍ₙ₊₁₎
   for(  uint i= 0; i < cdf_Gauss_n; ++i  ){
     x= (i+1) / (double) (1+cdf_Gauss_n);
@@ -134,193 +478,1894 @@ void cdfInv_precompute(){
   for(  uint i= 0; i < cdf_JBeta_n; ++i  ){
     // By symmetry, only need Beta values for p ≦ 0.5.  For example p=0.8, is the same p=0.2 with Gauss components swapped.
     x= 0.5 * i / (double) (cdf_JBeta_n);
-    cdfInv_JBeta[i]=  gsl_cdf_beta_Pinv( x, 0.5, 0.5 );
-    //printf( "cdfInv_JBeta[%u]= %g\n", i, cdfInv_JBeta[i] );
+    rule->JBeta[i]=  gsl_cdf_beta_Pinv( x, 0.5, 0.5 );
+    rule->JBetaWeight[i]=  1.0 / cdf_JBeta_n;
+    //printf( "cdfInv_JBeta[%u]= %g\n", i, rule->JBeta[i] );
+  }
+  for(  uint m= 0;  m < cdf_Gauss_n;  ++m  ){
+    for(  uint s= 0;  s < cdf_gamma_n;  ++s  ){
+      uint c=  m * cdf_gamma_n + s;
+      rule->mu[c]=  cdfInv_Gauss[m];
+      rule->sigma[c]=  sigma_of_precision( cdfInv_gamma[s] );
+      rule->logWeight[c]=  -log( (double) rule->components_n );
+    }
   }
+  free( cdfInv_Gauss );
+  free( cdfInv_gamma );
+}
+
+//  Precompute quantileRule from the run configuration.
+void cdfInv_precompute(){
+  prior_rule_quantiles( &quantileRule, cdf_Gauss_n, cdf_gamma_n, cdf_JBeta_n );
 }
 
 
 
-/* Compute Riemann sum to approximate the integral
+/* Compute a weighted sum over the nodes of rule to approximate the integral
  *
  * ∫ μ,σ  P[D,μ,σ]
  *
+ * Returns the log of the integral.
 */
-double data_prob_1component_bySumming(){
-  double prob_total= 0.0;
-  for(  uint m= 0;  m < cdf_Gauss_n;  ++m  ){
-    double mu= cdfInv_Gauss[m];
-    for(  uint s= 0;  s < cdf_gamma_n;  ++s  ){
-      double sigma=  sigma_of_precision( cdfInv_gamma[s] );
-      Gauss_params cur_params= {mu, sigma};
-      double curProb= 1.0;
-      for(  uint d= 0;  d < dataN;  ++d  ){
-        double newProb= GSLfun_ran_gaussian_pdf( data[d], cur_params );
-        curProb *= newProb;
-      }
-      prob_total += curProb;
-    }
+double data_prob_1component_byRule( const Dataset* data, const prior_rule* rule ){
+  data_summary summary=  data_summarize( data );
+  LogSumExp prob_total= LogSumExp_empty;
+  for(  uint c= 0;  c < rule->components_n;  ++c  ){
+    Gauss_params cur_params= {rule->mu[c], rule->sigma[c]};
+    LogSumExp_add(  &prob_total,  rule->logWeight[c]  +  data_summary_logLikelihood( &summary, cur_params )  );
+  }
+  return  LogSumExp_log( prob_total );
+}
+
+
+// Table of the Gaussian pdf of each datum, for every component node of a rule.
+// Laid out [component][datum] so that the innermost loop over the data is contiguous,
+// with each row of data->n values padded to an aligned length.
+
+//  Row of table for component c.
+double* data_pdf_row( double* data_pdf, const Dataset* data, uint c ){
+  return  data_pdf  +  (size_t) c * doubles_padded( data->n );
+}
+
+//  Allocate and fill the pdf table for data.
+double* data_pdf_precompute( const Dataset* data, const prior_rule* rule ){
+  double* data_pdf=  doubles_alloc( (size_t) rule->components_n * doubles_padded( data->n ) );
+  for(  uint c= 0;  c < rule->components_n;  ++c  ){
+    Gauss_params cur_params= {rule->mu[c], rule->sigma[c]};
+    GSLfun_ran_gaussian_pdf_n( data_pdf_row( data_pdf, data, c ), data->x, data->n, cur_params );
   }
-  return  prob_total / (double) (cdf_Gauss_n * cdf_gamma_n);
+  return  data_pdf;
 }
 
 
-/* Compute Riemann sum to approximate integral
+/* Compute a weighted sum over the nodes of rule to approximate the integral
  *
  * ∫ m,μ₁,σ₁,μ₂,σ₂  P[D,m,μ₁,σ₁,μ₂,σ₂]
  *
+ * Only components_n distinct (μ,σ) pairs occur in the grid,
+ * so their pdf values are tabulated once and the grid itself needs only multiply-adds.
+ * Terms bounded below a fraction pruneTolerance of the total are skipped, mostly after only part of the data.
+ *
+ * The grid holds every ordered pair of components, with mixCof ≦ ½.  Swapping the components
+ * and replacing mixCof by 1-mixCof gives the same likelihood, so instead each unordered pair {c₁,c₂}
+ * is visited once and evaluated at both mixCof and 1-mixCof, sharing the table lookups.
+ * When c₁ = c₂ the mixture is just c₁, so the likelihood is computed once for all mixCof.
+ *
+ * Returns the log of the integral.
 */
-double data_prob_2component_bySumming(){
-  double prob_total= 0.0;
-
-  for(  uint m1= 0;  m1 < cdf_Gauss_n;  ++m1  ){
-    double mu1= cdfInv_Gauss[m1];
-    for(  uint m2= 0;  m2 < cdf_Gauss_n;  ++m2  ){
-      double mu2= cdfInv_Gauss[m2];
-      for(  uint s1= 0;  s1 < cdf_gamma_n;  ++s1  ){
-        double sigma1=  sigma_of_precision( cdfInv_gamma[s1] );
-        Gauss_params cur_params1= {mu1, sigma1};
-        for(  uint s2= 0;  s2 < cdf_gamma_n;  ++s2  ){
-          double sigma2=  sigma_of_precision( cdfInv_gamma[s2] );
-          Gauss_params cur_params2= {mu2, sigma2};
-          for(  uint mi= 0;  mi < cdf_JBeta_n;  ++mi  ){
-            double mixCof= cdfInv_JBeta[mi];
-            double curProb= 1.0;
-            for(  uint d= 0;  d < dataN;  ++d  ){
-              double newProb=  mixCof  * GSLfun_ran_gaussian_pdf( data[d], cur_params1 )
-                +           (1-mixCof) * GSLfun_ran_gaussian_pdf( data[d], cur_params2 );
-              curProb *= newProb;
-            }
-            prob_total += curProb;
+double data_prob_2component_byRule( const Dataset* data, const prior_rule* rule ){
+  LogSumExp prob_total= LogSumExp_empty;
+
+  double* data_pdf=  data_pdf_precompute( data, rule );
+  uint componentsN=  rule->components_n;
+
+  // Terms with only one component come first, to give the pruning threshold below a good start.
+  for(  uint c1= 0;  c1 < componentsN;  ++c1  ){
+    const double* pdf1=  data_pdf_row( data_pdf, data, c1 );
+    double curProb= 1.0;  int curExpo= 0;
+    for(  uint d= 0;  d < data->n;  ++d  ){
+      scaledProd_mul( &curProb, &curExpo, pdf1[d] );
+    }
+    LogSumExp_add(  &prob_total,  2.0 * rule->logWeight[c1]  +  scaledProd_log( curProb, curExpo )  );
+  }
+
+  // A mixture density of a datum never exceeds the larger of its component densities, so
+  // logSuffix[k] bounds the log product of the factors for data 8k..n-1.  Terms whose bound falls below
+  // logNegligible are dropped; all of them together change the total by at most a fraction pruneTolerance.
+  const uint checkEvery= 8;
+  double* logSuffix=  doubles_alloc( (data->n + checkEvery-1) / checkEvery );
+  double logJBetaWeightMax= -INFINITY;
+  for(  uint mi= 0;  mi < rule->JBeta_n;  ++mi  )   logJBetaWeightMax=  fmax( logJBetaWeightMax, log( rule->JBetaWeight[mi] ) );
+  double logTermsN=  log( 2.0 * componentsN * componentsN * rule->JBeta_n );
+
+  for(  uint c1= 0;  c1 < componentsN;  ++c1  ){
+    const double* pdf1=  data_pdf_row( data_pdf, data, c1 );
+
+    for(  uint c2= c1+1;  c2 < componentsN;  ++c2  ){
+      const double* pdf2=  data_pdf_row( data_pdf, data, c2 );
+      double logNegligible=  LogSumExp_log( prob_total )  +  log( pruneTolerance )  -  logTermsN;
+      double logPairWeightBase=  rule->logWeight[c1] + rule->logWeight[c2];
+
+      double boundProb= 1.0;  int boundExpo= 0;
+      for(  uint d= data->n;  d-- > 0;  ){
+        scaledProd_mul(  &boundProb, &boundExpo,  fmax( pdf1[d], pdf2[d] )  );
+        if(  d % checkEvery == 0  )   logSuffix[d / checkEvery]=  scaledProd_log( boundProb, boundExpo );
+      }
+      if(  logPairWeightBase + logJBetaWeightMax + logSuffix[0]  <  logNegligible  )   continue;
+
+      for(  uint mi= 0;  mi < rule->JBeta_n;  ++mi  ){
+        double mixCof= rule->JBeta[mi];
+        double logPairWeight=  logPairWeightBase + log( rule->JBetaWeight[mi] );
+        double prob12= 1.0;  int expo12= 0;  // mixCof * pdf1  +  (1-mixCof) * pdf2
+        double prob21= 1.0;  int expo21= 0;  // mixCof * pdf2  +  (1-mixCof) * pdf1
+        uint d= 0;
+        for(  ;  d < data->n;  ++d  ){
+          if(  d % checkEvery == 0  ){
+            double logRest=  logPairWeight + logSuffix[d / checkEvery];
+            if(  logRest + scaledProd_log( prob12, expo12 ) < logNegligible  &&
+                 logRest + scaledProd_log( prob21, expo21 ) < logNegligible  )   break;
           }
+          double diff=  pdf1[d] - pdf2[d];
+          scaledProd_mul( &prob12, &expo12,  pdf2[d]  +  mixCof * diff  );
+          scaledProd_mul( &prob21, &expo21,  pdf1[d]  -  mixCof * diff  );
         }
+        if(  d < data->n  )   continue;
+        LogSumExp_add( &prob_total, logPairWeight + scaledProd_log( prob12, expo12 ) );
+        LogSumExp_add( &prob_total, logPairWeight + scaledProd_log( prob21, expo21 ) );
       }
     }
   }
-  return  prob_total / (double) (cdf_Gauss_n * cdf_Gauss_n * cdf_gamma_n * cdf_gamma_n * cdf_JBeta_n);
+  free( logSuffix );
+  free( data_pdf );
+  return  LogSumExp_log( prob_total );
+}
+
+
+//  Equal weight Riemann sums over prior quantiles
+double data_prob_1component_bySumming( const Dataset* data, GSLfun_RNG* unused, uint* unusedN ){
+  return  data_prob_1component_byRule( data, &quantileRule );
+}
+
+double data_prob_2component_bySumming( const Dataset* data, GSLfun_RNG* unused, uint* unusedN ){
+  return  data_prob_2component_byRule( data, &quantileRule );
+}
+
+
+
+/* ───────────  Monte Carlo integration in parallel chunks  ────────── */
+
+// Return the moments of the terms for samples begin...begin+n-1 of a Monte Carlo integral, drawing from rng.
+typedef  LogMoments  (*sampling_chunk_fn)( const Dataset* data, const void* context, GSLfun_RNG* rng, uint begin, uint n );
+
+typedef struct{
+  const Dataset* data;
+  const void* context;
+  sampling_chunk_fn chunk_moments;
+  uint samplesN;
+  uint chunkSize;
+  ulong stream;
+  double deadline;         // Stop once the clock passes this, if positive
+  LogMoments* moments;     // Of each chunk
+  bool* done;              // Whether each chunk has been computed
+  pthread_mutex_t lock;    // Guards the fields below, and done and moments
+  uint prefixN;            // Number of chunks, all done, merged in order into prefix
+  LogMoments prefix;
+  atomic_uint stopAt;      // Chunks from this one on are not needed
+} sampling_job;
+
+double clock_seconds(){
+  struct timespec now;
+  clock_gettime( CLOCK_MONOTONIC, &now );
+  return  now.tv_sec  +  1e-9 * now.tv_nsec;
+}
+
+//  Whether the chunks merged so far into job->prefix are enough.
+bool sampling_job_converged( const sampling_job* job ){
+  if(  job->deadline > 0.0  &&  clock_seconds() > job->deadline  )   return  true;
+  return  sampleTolerance > 0.0
+    &&    job->prefixN >= sampleMinChunks
+    &&    LogMoments_relStdErr( job->prefix ) <= sampleTolerance;
+}
+
+void sampling_job_chunk( uint chunk, void* job_ptr ){
+  sampling_job* job= job_ptr;
+  if(  chunk >= atomic_load( &job->stopAt )  )   return;
+
+  GSLfun_RNG* rng=  GSLfun_RNG_alloc(  GSLfun_stream_child( job->stream, chunk )  );
+  uint begin=  chunk * job->chunkSize;
+  uint n=  (begin + job->chunkSize > job->samplesN)?  job->samplesN - begin : job->chunkSize;
+  LogMoments moments=  job->chunk_moments( job->data, job->context, rng, begin, n );
+  GSLfun_RNG_free( rng );
+
+  pthread_mutex_lock( &job->lock );
+  job->moments[chunk]=  moments;
+  job->done[chunk]=  true;
+  while(  job->prefixN < atomic_load( &job->stopAt )  &&  job->done[job->prefixN]  ){
+    LogMoments_merge( &job->prefix, job->moments[job->prefixN] );
+    ++job->prefixN;
+    if(  sampling_job_converged( job )  )   atomic_store( &job->stopAt, job->prefixN );
+  }
+  pthread_mutex_unlock( &job->lock );
+}
+
+//  Number of samples per chunk for an integral of samplesN samples.
+uint sampling_chunkSize( uint samplesN ){
+  const uint minChunksN=  sampleMinChunks * sampleMinChunks;
+  uint size=  (samplesN + minChunksN - 1) / minChunksN;
+  return  (size < 1)?  1 : (size > sampleChunkSize)?  sampleChunkSize : size;
+}
+
+/*  Return the log of the mean of up to samplesN terms, computed by chunk_moments in chunks of sampling_chunkSize
+ *  spread over integratorThreadsN threads, and set *samplesUsed to the number of terms actually used.
+ *
+ *  Chunks are merged in chunk order, and sampling stops at the first prefix of chunks whose estimate meets
+ *  sampleTolerance or exhausts sampleTimeBudget; chunks beyond it that were already computed are discarded.
+ *  The chunks' RNG streams are derived from one draw from rng, so unless stopped by the time budget,
+ *  the result does not depend on the number of threads.
+ */
+double sampling_logMean( const Dataset* data, GSLfun_RNG* rng, uint samplesN,
+                         sampling_chunk_fn chunk_moments, const void* context, uint* samplesUsed ){
+  uint chunkSize=  sampling_chunkSize( samplesN );
+  uint chunksN=  (samplesN + chunkSize - 1) / chunkSize;
+  sampling_job job=  {data, context, chunk_moments, samplesN, chunkSize, GSLfun_ran_stream_r( rng ),
+                      (sampleTimeBudget > 0.0)?  clock_seconds() + sampleTimeBudget : 0.0,
+                      malloc( chunksN * sizeof(LogMoments) ),  calloc( chunksN, sizeof(bool) ),
+                      PTHREAD_MUTEX_INITIALIZER,  0,  LogMoments_empty,  chunksN};
+
+  parallel_for( chunksN, integratorThreadsN, sampling_job_chunk, &job );
+
+  free( job.moments );
+  free( job.done );
+  if(  samplesUsed  )   *samplesUsed=  job.prefix.n;
+  return  LogMoments_logMean( job.prefix );
+}
+
+
+//  log Π_d ( mixCof·pdf1[d] + (1-mixCof)·pdf2[d] )
+double mixture_logLikelihood( uint n, double mixCof, const double* pdf1, const double* pdf2 ){
+  double curProb= 1.0;  int curExpo= 0;
+  for( uint i= 0; i < n; ++i ){
+    double newProb=  (1-mixCof) * pdf2[i]  +  mixCof * pdf1[i];
+    scaledProd_mul( &curProb, &curExpo, newProb );
+  }
+  return  scaledProd_log( curProb, curExpo );
 }
 
 
 
 /*  Use sampling to estimate
  *  ∫ μ,σ  P[D,μ,σ]
+ *
+ *  The samples come from priorBank if set, otherwise they are drawn in chunks as described for sampling_logMean.
+ *  Returns the log of the estimate.
  */
-double data_prob_1component_bySampling(){
-  double curProb, prob_total= 0.0;
+LogMoments data_prob_1component_bySampling_chunk( const Dataset* data, const void* summary, GSLfun_RNG* rng,
+                                                 uint begin, uint n ){
+  Gauss_params_batch drawn;
+  const Gauss_params_batch* samples=  priorBank?  &priorBank->Gauss1 : NULL;
+  if(  !priorBank  ){
+    drawn=  Gauss_params_batch_alloc( n );
+    prior_Gauss_params_sample_batch_r( rng, &drawn, 0, n );
+    samples= &drawn;
+    begin= 0;
+  }
+  double* logProbs=  doubles_alloc( n );
+  data_summary_logLikelihood_batch( logProbs, summary, samples, begin, n );
 
-  for( uint iter= 0;  iter < sampleRepeatNum; ++iter ){
-    Gauss_params params= prior_Gauss_params_sample();
-    curProb= 1.0;
-    for(  uint d= 0;  d < dataN;  ++d ){
-      curProb *= GSLfun_ran_gaussian_pdf( data[d], params );
-    }
-    prob_total += curProb;
+  LogMoments terms= LogMoments_empty;
+  for(  uint i= 0;  i < n;  ++i  ){
+    LogMoments_add( &terms, logProbs[i] );
   }
-  return  prob_total / (double) sampleRepeatNum;
+  free( logProbs );
+  if(  !priorBank  )   Gauss_params_batch_free( &drawn );
+  return  terms;
+}
+
+double data_prob_1component_bySampling( const Dataset* data, GSLfun_RNG* rng, uint* samplesUsed ){
+  data_summary summary=  data_summarize( data );
+  return  sampling_logMean( data, rng, sampleRepeatNum, data_prob_1component_bySampling_chunk, &summary, samplesUsed );
 }
 
 
 
 /*  Use sampling to estimate
  *  ∫ m,μ₁,σ₁,μ₂,σ₂  P[D,m,μ₁,σ₁,μ₂,σ₂]
+ *
+ *  The samples come from priorBank if set, otherwise they are drawn in chunks as described for sampling_logMean.
+ *  Returns the log of the estimate.
  */
-double data_prob_2component_bySampling(){
-  double curProb, prob_total= 0.0;
+LogMoments data_prob_2component_bySampling_chunk( const Dataset* data, const void* unused, GSLfun_RNG* rng,
+                                                 uint begin, uint n ){
+  Gauss_mixture_params_batch drawn;
+  const Gauss_mixture_params_batch* samples= priorBank;
+  if(  !priorBank  ){
+    drawn=  Gauss_mixture_params_batch_alloc( n );
+    prior_Gauss_mixture_params_sample_batch_r( rng, &drawn, 0, n );
+    samples= &drawn;
+    begin= 0;
+  }
+  const Gauss_params_batch* Gauss1=  &samples->Gauss1;
+  const Gauss_params_batch* Gauss2=  &samples->Gauss2;
 
-  for( uint iter= 0;  iter < sampleRepeatNum; ++iter ){
-    Gauss_mixture_params params=  prior_Gauss_mixture_params_sample();
-    curProb= 1.0;
-    for( uint i= 0; i < dataN; ++i ){
-      double newProb=
-        (1-params.mixCof) * GSLfun_ran_gaussian_pdf( data[i], params.Gauss2 )
-        +  params.mixCof  * GSLfun_ran_gaussian_pdf( data[i], params.Gauss1 );
-      curProb *= newProb;
-    }
-    prob_total += curProb;
+  double* pdf1=  doubles_alloc( data->n );
+  double* pdf2=  doubles_alloc( data->n );
+  LogMoments terms= LogMoments_empty;
+  for(  uint iter= begin;  iter < begin + n;  ++iter  ){
+    GSLfun_ran_gaussian_pdf_n_inv( pdf1, data->x, data->n, Gauss1->mu[iter], Gauss1->invSigma[iter], Gauss1->logSigma[iter] );
+    GSLfun_ran_gaussian_pdf_n_inv( pdf2, data->x, data->n, Gauss2->mu[iter], Gauss2->invSigma[iter], Gauss2->logSigma[iter] );
+    LogMoments_add(  &terms,  mixture_logLikelihood( data->n, samples->mixCof[iter], pdf1, pdf2 )  );
   }
-  return  prob_total / (double) sampleRepeatNum;
+  free( pdf1 );
+  free( pdf2 );
+  if(  !priorBank  )   Gauss_mixture_params_batch_free( &drawn );
+  return  terms;
 }
 
+double data_prob_2component_bySampling( const Dataset* data, GSLfun_RNG* rng, uint* samplesUsed ){
+  return  sampling_logMean( data, rng, sampleRepeatNum, data_prob_2component_bySampling_chunk, NULL, samplesUsed );
+}
 
 
-int main( int argc, char *argv[] ){
 
-  uint datasets_n= 10;
+/* ───────────  Integrands over the unit cube  ────────── */
+/*  Mapping u ∈ (0,1)ᵈ through the inverse CDFs of the prior turns  ∫ P[θ] P[D|θ] dθ  into  ∫ P[D|θ(u)] du,
+ *  so any rule for integrating over the unit cube integrates over the prior.
+ *  Coordinates are (μ, precision) for one component, and (m, μ₁, precision₁, μ₂, precision₂) for two.
+ */
 
-  {
-    char usage_fmt[]=  "Usage: %s [num_datasets]\n";
-    switch( argc ){
-    case 1:
-      break;
-    case 2:
-      datasets_n=  atoi( argv[1] );
-      if( !datasets_n ){
-        printf(  usage_fmt, argv[0]  );
-        exit( 64 );
-      }
-      break;
-    default:
-      printf(  usage_fmt, argv[0]  );
-      exit( 64 );
-    }
+//  Each coordinate depends on one u alone.
+double prior_mixCof_of_u( double u ){
+  return  gsl_cdf_beta_Pinv( u, 0.5, 0.5 );
+}
+
+double prior_mu_of_u( double u ){
+  return  mu_prior_params.mu  +  gsl_cdf_gaussian_Pinv( u, mu_prior_params.sigma );
+}
+
+double prior_sigma_of_u( double u ){
+  return  sigma_of_precision(  gsl_cdf_gamma_Pinv( u, sigma_prior_param_a, sigma_prior_param_b )  );
+}
+
+Gauss_params prior_Gauss_params_of_u( const double* u ){
+  Gauss_params params=  {prior_mu_of_u( u[0] ),  prior_sigma_of_u( u[1] )};
+  return  params;
+}
+
+Gauss_mixture_params prior_Gauss_mixture_params_of_u( const double* u ){
+  Gauss_mixture_params params;
+  params.mixCof=  prior_mixCof_of_u( u[0] );
+  params.Gauss1=  prior_Gauss_params_of_u( u + 1 );
+  params.Gauss2=  prior_Gauss_params_of_u( u + 3 );
+  return  params;
+}
+
+//  log P[D|θ(u)] for one component
+double data_logLikelihood_1component_u( const data_summary* summary, const double* u ){
+  return  data_summary_logLikelihood(  summary,  prior_Gauss_params_of_u( u )  );
+}
+
+//  log P[D|θ] for two components, using pdf1 and pdf2 as scratch space for data->n values each.
+double data_logLikelihood_2component( const Dataset* data, Gauss_mixture_params params, double* pdf1, double* pdf2 ){
+  GSLfun_ran_gaussian_pdf_n( pdf1, data->x, data->n, params.Gauss1 );
+  GSLfun_ran_gaussian_pdf_n( pdf2, data->x, data->n, params.Gauss2 );
+  return  mixture_logLikelihood( data->n, params.mixCof, pdf1, pdf2 );
+}
+
+//  log P[D|θ(u)] for two components, with scratch space as above.
+double data_logLikelihood_2component_u( const Dataset* data, const double* u, double* pdf1, double* pdf2 ){
+  return  data_logLikelihood_2component(  data,  prior_Gauss_mixture_params_of_u( u ),  pdf1, pdf2  );
+}
+
+
+
+/*  Quasi-Monte Carlo:  average the integrands over points of a randomly shifted Sobol sequence,
+ *  whose error usually shrinks nearly as 1/n rather than 1/√n.
+ *  Chunks of the sequence share one shift, drawn from rng, and start at their sample index.
+ *  The standard error used to stop early treats the points as independent, so it overstates the error.
+ */
+uint qmcSampleNum= 1 << 19;
+
+typedef struct{
+  data_summary summary;
+  uint shift[5];
+} qmc_context;
+
+LogMoments data_prob_1component_byQMC_chunk( const Dataset* data, const void* qmc_ptr, GSLfun_RNG* unused,
+                                             uint begin, uint n ){
+  const qmc_context* qmc= qmc_ptr;
+  GSLfun_sobol sobol;
+  GSLfun_sobol_init( &sobol, 2, qmc->shift, begin );
+  double u[2];
+  LogMoments terms= LogMoments_empty;
+  for(  uint iter= 0;  iter < n;  ++iter  ){
+    GSLfun_sobol_next( &sobol, u );
+    LogMoments_add(  &terms,  data_logLikelihood_1component_u( &qmc->summary, u )  );
   }
+  return  terms;
+}
 
-  GSLfun_setup();
-  double prob_data1_bySampling, prob_data2_bySampling;
-  double prob_data1_bySumming,  prob_data2_bySumming;
+double data_prob_1component_byQMC( const Dataset* data, GSLfun_RNG* rng, uint* samplesUsed ){
+  qmc_context qmc;
+  qmc.summary=  data_summarize( data );
+  GSLfun_sobol_shift_r( rng, qmc.shift, 2 );
+  return  sampling_logMean( data, rng, qmcSampleNum, data_prob_1component_byQMC_chunk, &qmc, samplesUsed );
+}
 
-  cdfInv_precompute();
+LogMoments data_prob_2component_byQMC_chunk( const Dataset* data, const void* qmc_ptr, GSLfun_RNG* unused,
+                                             uint begin, uint n ){
+  const qmc_context* qmc= qmc_ptr;
+  GSLfun_sobol sobol;
+  GSLfun_sobol_init( &sobol, 5, qmc->shift, begin );
+  double u[5];
+  double* pdf1=  doubles_alloc( data->n );
+  double* pdf2=  doubles_alloc( data->n );
+  LogMoments terms= LogMoments_empty;
+  for(  uint iter= 0;  iter < n;  ++iter  ){
+    GSLfun_sobol_next( &sobol, u );
+    LogMoments_add(  &terms,  data_logLikelihood_2component_u( data, u, pdf1, pdf2 )  );
+  }
+  free( pdf1 );
+  free( pdf2 );
+  return  terms;
+}
 
+double data_prob_2component_byQMC( const Dataset* data, GSLfun_RNG* rng, uint* samplesUsed ){
+  qmc_context qmc;
+  GSLfun_sobol_shift_r( rng, qmc.shift, 5 );
+  return  sampling_logMean( data, rng, qmcSampleNum, data_prob_2component_byQMC_chunk, &qmc, samplesUsed );
+}
 
-  uint model1_sampling_favors1=  0;
-  uint model1_summing__favors1=  0;
-  uint model2_sampling_favors1=  0;
-  uint model2_summing__favors1=  0;
 
 
+/* ───────────  Pooled model evidence with μ integrated analytically  ────────── */
 
-  printf(  "Starting computation for %d datasets each. ...\n",  datasets_n  );
+/* Given σ, the integral over μ of the likelihood times the Normal prior on μ has the closed form
+ *
+ *  ∫ μ  P[D,μ|σ]  =  (2πσ²)^(-(n-1)/2) · n^(-½) · exp( -S/2σ² ) · N( x̄; μ₀, σ₀² + σ²/n )
+ *
+ * where x̄ is the sample mean and S the sum of squared deviations from it.
+ * Returns its log.
+ */
+double data_logProb_1component_givenSigma( double sigma, const data_summary* summary ){
+  double n= summary->n;
+  double var= sigma * sigma;
+  Gauss_params mean_params=
+    {mu_prior_params.mu,  sqrt( mu_prior_params.sigma * mu_prior_params.sigma  +  var / n )};
+  return  -0.5 * (n-1) * log( 2.0 * M_PI * var )  -  0.5 * log( n )  -  summary->sumSqDev / (2.0 * var)
+    +     GSLfun_ran_gaussian_logpdf( summary->mean, mean_params );
+}
+
+
+typedef struct{
+  data_summary summary;
+  double logMax;  // Subtracted before exponentiating, so the integrand peaks near 1
+} logPrecision_integrand_params;
+
+//  log P[D,t] for t= log(precision), with μ integrated out.
+double data_logProb_1component_givenLogPrecision( double t, const logPrecision_integrand_params* params ){
+  double a= sigma_prior_param_a,  theta= sigma_prior_param_b;
+  // Gamma prior density of the precision, times the Jacobian  d precision / dt
+  double logPrior=  a * t  -  exp( t ) / theta  -  gsl_sf_lngamma( a )  -  a * log( theta );
+  return  logPrior
+    +     data_logProb_1component_givenSigma( exp( -0.5 * t ), &params->summary );
+}
+
+double logPrecision_integrand( double t, void* params ){
+  logPrecision_integrand_params* p= params;
+  return  exp(  data_logProb_1component_givenLogPrecision( t, p )  -  p->logMax  );
+}
 
-  printf( "\nData generated with one component\n" );
-  for(  uint iter= 0;  iter < datasets_n;  ++iter  ){
-    Gauss_params model_params = prior_Gauss_params_sample();
-    printf(  "generating data with: (μ,σ) =  (%4.2f,%4.2f)\n", model_params.mu, model_params.sigma  );
-    data_generate_1component( model_params );
 
-    prob_data1_bySampling=  data_prob_1component_bySampling();
-    prob_data2_bySampling=  data_prob_2component_bySampling();
-    prob_data1_bySumming =  data_prob_1component_bySumming();
-    prob_data2_bySumming =  data_prob_2component_bySumming();
-    printf( "Integrals by sampling= (%g,%g)  by summing: (%g,%g)\n\n",
-            prob_data1_bySampling, prob_data2_bySampling,
-            prob_data1_bySumming, prob_data2_bySumming );
-    if(  prob_data1_bySampling > prob_data2_bySampling  )   ++model1_sampling_favors1;
-    if(  prob_data1_bySumming  > prob_data2_bySumming   )   ++model1_summing__favors1;
+//  Return t between tPeak and tFar at which the log integrand has dropped by drop from its peak.
+//  Assumes the integrand is unimodal.
+double logPrecision_dropPoint( double tPeak, double tFar, double drop, const logPrecision_integrand_params* params ){
+  double target=  params->logMax - drop;
+  if(  data_logProb_1component_givenLogPrecision( tFar, params ) > target  )   return  tFar;
+  for(  uint iter= 0;  iter < 100;  ++iter  ){
+    double t= 0.5 * (tPeak + tFar);
+    if(  data_logProb_1component_givenLogPrecision( t, params ) > target  )   tPeak= t;
+    else                                                                         tFar=  t;
   }
+  return  tFar;
+}
 
 
-  printf( "\nData generated with two components\n" );
-  for(  uint iter= 0;  iter < datasets_n;  ++iter  ){
-    Gauss_mixture_params model_params=  prior_Gauss_mixture_params_sample();
-    printf(  "generating data with:  m; (μ1,σ1); (μ2,σ2) =  %5.3f; (%4.2f,%4.2f); (%4.2f,%4.2f)\n",
-             model_params.mixCof,
-             model_params.Gauss1.mu, model_params.Gauss1.sigma,
-             model_params.Gauss2.mu, model_params.Gauss2.sigma  );
-    data_generate_2component( model_params );
-
-    prob_data1_bySampling=  data_prob_1component_bySampling();
-    prob_data2_bySampling=  data_prob_2component_bySampling();
-    prob_data1_bySumming =  data_prob_1component_bySumming();
-    prob_data2_bySumming =  data_prob_2component_bySumming();
-    printf( "Integrals by sampling= (%g,%g)  by summing: (%g,%g)\n\n",
-            prob_data1_bySampling, prob_data2_bySampling,
-            prob_data1_bySumming, prob_data2_bySumming );
-    if(  prob_data1_bySampling > prob_data2_bySampling  )   ++model2_sampling_favors1;
-    if(  prob_data1_bySumming  > prob_data2_bySumming   )   ++model2_summing__favors1;
-  }
-
-  printf(  "By sampling: Model1 data, correct selection %u/%u\n", model1_sampling_favors1, datasets_n  );
-  printf(  "             Model2 data, correct selection %u/%u\n", (datasets_n - model2_sampling_favors1), datasets_n  );
-  printf(  "By summing:  Model1 data, correct selection %u/%u\n", model1_summing__favors1, datasets_n  );
-  printf(  "             Model2 data, correct selection %u/%u\n", (datasets_n - model2_summing__favors1), datasets_n  );
+// GSL's error handler is process wide, so threads share one switch turning it off, counted under a lock;
+// the default handler, which aborts, is restored once no thread needs it off.
+pthread_mutex_t gslErrorsLock=  PTHREAD_MUTEX_INITIALIZER;
+uint gslErrorsOffN= 0;
+gsl_error_handler_t* gslSavedErrorHandler;
+
+void gsl_errors_off_begin(){
+  pthread_mutex_lock( &gslErrorsLock );
+  if(  gslErrorsOffN++ == 0  )   gslSavedErrorHandler=  gsl_set_error_handler_off();
+  pthread_mutex_unlock( &gslErrorsLock );
+}
+
+void gsl_errors_off_end(){
+  pthread_mutex_lock( &gslErrorsLock );
+  if(  --gslErrorsOffN == 0  )   gsl_set_error_handler( gslSavedErrorHandler );
+  pthread_mutex_unlock( &gslErrorsLock );
+}
+
+
+/*  Compute  ∫ μ,σ  P[D,μ,σ]  with μ integrated analytically and log(precision)
+ *  by adaptive Gauss-Kronrod quadrature around the peak of the integrand.
+ *
+ *  Accurate to about 1e-10 relative error, so it serves as a reference for the other pooled model integrators.
+ *  If quadrature stops short of that, from roundoff or running out of subintervals, a warning giving its
+ *  error estimate is printed and the best estimate is used anyway.
+ *  Returns the log of the integral.
+ */
+double data_prob_1component_exact( const Dataset* data ){
+  const double tMin= -60.0,  tMax= 60.0,  tStep= 0.25;
+  logPrecision_integrand_params params=  {data_summarize( data ),  0.0};
+
+  // Coarse scan for the peak, then golden section search around it
+  double tPeak= tMin,  logMax= -INFINITY;
+  for(  double t= tMin;  t <= tMax;  t += tStep  ){
+    double logProb=  data_logProb_1component_givenLogPrecision( t, &params );
+    if(  logProb > logMax  ){  logMax= logProb;  tPeak= t;  }
+  }
+  const double golden=  0.5 * (sqrt(5.0) - 1.0);
+  double lo= tPeak - tStep,  hi= tPeak + tStep;
+  for(  uint iter= 0;  iter < 100;  ++iter  ){
+    double t1=  hi - golden * (hi - lo),  t2=  lo + golden * (hi - lo);
+    if(  data_logProb_1component_givenLogPrecision( t1, &params )
+         > data_logProb_1component_givenLogPrecision( t2, &params )  )   hi= t2;
+    else                                                                 lo= t1;
+  }
+  tPeak=  0.5 * (lo + hi);
+  params.logMax=  data_logProb_1component_givenLogPrecision( tPeak, &params );
+
+  // Beyond a drop of e⁻⁶⁰ from the peak the integrand is negligible
+  double points[3]=  {logPrecision_dropPoint( tPeak, tMin, 60.0, &params ),
+                      tPeak,
+                      logPrecision_dropPoint( tPeak, tMax, 60.0, &params )};
+
+  const size_t intervalsMax= 1000;
+  gsl_integration_workspace* workspace=  gsl_integration_workspace_alloc( intervalsMax );
+  gsl_function integrand=  {logPrecision_integrand, &params};
+  double integral, abserr;
+  gsl_errors_off_begin();
+  int status=  gsl_integration_qagp( &integrand, points, 3, 0.0, 1e-10, intervalsMax, workspace, &integral, &abserr );
+  gsl_errors_off_end();
+  gsl_integration_workspace_free( workspace );
+  if(  status  ){
+    fprintf(  stderr, "Warning: exact pooled integral: %s, estimated relative error %g\n",
+              gsl_strerror( status ), abserr / integral  );
+  }
+
+  return  params.logMax + log( integral );
+}
+
+
+
+/* ───────────  Importance sampling from proposals fit to the data  ────────── */
+/*  Sampling from the prior wastes nearly all samples when the data pin the parameters down.
+ *  Instead draw θ from a proposal q fit to summaries of the data and average  P[θ] P[D|θ] / q(θ).
+ *  Each proposal is a defensive mixture: a fraction importanceDefensive of it is the prior itself,
+ *  which bounds the weights wherever the data-driven part is too narrow.
+ *  Parameters are drawn as (μ, precision), in which the prior density is simplest.
+ */
+
+uint importanceSampleNum= 20000;
+const double importanceWiden= 3.0;        // Proposals act as if they saw this many times fewer data points
+const double importanceDefensive= 0.1;    // Weight of the prior in each proposal mixture
+
+
+double prior_Gauss_params_logpdf( double mu, double precision ){
+  return  GSLfun_ran_gaussian_logpdf( mu, mu_prior_params )
+    +     GSLfun_ran_gamma_logpdf( precision, sigma_prior_param_a, sigma_prior_param_b );
+}
+
+
+// Normal-gamma proposal for one component:  precision ~ Γ(shape,scale),  μ|precision ~ N( mean, 1/√(nEff·precision) )
+typedef struct{
+  double mean;
+  double nEff;
+  double shape;
+  double scale;
+} component_proposal;
+
+//  Roughly the posterior given n points with the given mean and sum of squared deviations, widened by importanceWiden.
+//  Dividing both the shape and the rate of the precision's posterior keeps its mean but fattens both tails,
+//  so the weights stay bounded even for a cluster of one point.
+component_proposal component_proposal_make( double n, double mean, double sumSqDev ){
+  component_proposal proposal;
+  proposal.mean=   mean;
+  proposal.nEff=   n / importanceWiden;
+  proposal.shape=  (sigma_prior_param_a  +  0.5 * n) / importanceWiden;
+  proposal.scale=  importanceWiden / (1.0 / sigma_prior_param_b  +  0.5 * sumSqDev);
+  return  proposal;
+}
+
+Gauss_params component_proposal_params( const component_proposal* proposal, double precision ){
+  Gauss_params params=  {proposal->mean,  sigma_of_precision( proposal->nEff * precision )};
+  return  params;
+}
+
+void component_proposal_sample_r( GSLfun_RNG* rng, const component_proposal* proposal, double* mu, double* precision ){
+  *precision=  GSLfun_ran_gamma_r( rng, proposal->shape, proposal->scale );
+  *mu=  GSLfun_ran_gaussian_r(  rng,  component_proposal_params( proposal, *precision )  );
+}
+
+double component_proposal_logpdf( const component_proposal* proposal, double mu, double precision ){
+  return  GSLfun_ran_gamma_logpdf( precision, proposal->shape, proposal->scale )
+    +     GSLfun_ran_gaussian_logpdf(  mu,  component_proposal_params( proposal, precision )  );
+}
+
+
+typedef struct{
+  data_summary summary;
+  component_proposal pooled;    // Fit to all the data
+  component_proposal low, high; // Fit to a split of the data into two clusters
+  component_proposal core;      // Fit to the points near the median, ignoring outliers
+  double mixCof_low, mixCof_high;  // Beta parameters for the weight of the low component
+} importance_proposal;
+
+const uint importanceSplitSteps= 20;  // EM iterations refining the split
+const double importanceCoreWidth= 2.5;
+
+
+/*  Fit proposals to data.  The split starts as the cut of the sorted data into two runs
+ *  minimizing the within-run sum of squared deviations, which EM then refines into overlapping clusters
+ *  (a hard cut puts the tail of a wide component into the cluster of a narrow one).
+ */
+importance_proposal importance_proposal_make( const Dataset* data ){
+  importance_proposal proposal;
+  uint n=  data->n;
+  proposal.summary=  data_summarize( data );
+  proposal.pooled=  component_proposal_make( n, proposal.summary.mean, proposal.summary.sumSqDev );
+  proposal.low=  proposal.high=  proposal.core=  proposal.pooled;
+  proposal.mixCof_low=  proposal.mixCof_high=  0.5;
+  if(  n < 2  )   return  proposal;
+
+  double* sorted=  doubles_alloc( n );
+  memcpy( sorted, data->x, n * sizeof(double) );
+  qsort( sorted, n, sizeof(double), CMPdata );
+
+  // Core:  points within importanceCoreWidth robust standard deviations, 1.4826 × the median absolute deviation, of the median
+  double* absDev=  doubles_alloc( n );
+  double median=  0.5 * (sorted[(n-1)/2] + sorted[n/2]);
+  for(  uint i= 0;  i < n;  ++i  )   absDev[i]=  fabs( sorted[i] - median );
+  qsort( absDev, n, sizeof(double), CMPdata );
+  double coreHalfWidth=  importanceCoreWidth * 1.4826 * 0.5 * (absDev[(n-1)/2] + absDev[n/2]);
+  free( absDev );
+  uint coreBegin= 0, coreEnd= n;
+  while(  sorted[coreBegin]  < median - coreHalfWidth  )   ++coreBegin;
+  while(  sorted[coreEnd-1]  > median + coreHalfWidth  )   --coreEnd;
+  if(  coreEnd - coreBegin  >=  2  ){
+    Dataset core=  {sorted + coreBegin,  coreEnd - coreBegin};
+    data_summary coreSummary=  data_summarize( &core );
+    proposal.core=  component_proposal_make( core.n, coreSummary.mean, coreSummary.sumSqDev );
+  }
+  double sum= 0.0, sumSq= 0.0;
+  for(  uint i= 0;  i < n;  ++i  ){
+    sum   += sorted[i];
+    sumSq += sorted[i] * sorted[i];
+  }
+
+  uint kBest= 1;  double bestCost= INFINITY;
+  double lowSum= 0.0, lowSumSq= 0.0;
+  for(  uint k= 1;  k < n;  ++k  ){
+    lowSum   += sorted[k-1];
+    lowSumSq += sorted[k-1] * sorted[k-1];
+    double highSum=  sum - lowSum;
+    double cost=  (lowSumSq - lowSum * lowSum / k)  +  (sumSq - lowSumSq  -  highSum * highSum / (n-k));
+    if(  cost < bestCost  ){
+      bestCost= cost;  kBest= k;
+    }
+  }
+
+  // Soft counts, means and sums of squared deviations of the low [0] and high [1] clusters
+  double count[2]=  {kBest, n - kBest};
+  double mean[2]=  {0.0, 0.0};
+  double sumSqDev[2]=  {0.0, 0.0};
+  for(  uint i= 0;  i < n;  ++i  )   mean[i >= kBest] += sorted[i] / count[i >= kBest];
+  for(  uint i= 0;  i < n;  ++i  )   sumSqDev[i >= kBest] += (sorted[i] - mean[i >= kBest]) * (sorted[i] - mean[i >= kBest]);
+
+  const double varianceFloor=  1e-3 * proposal.summary.sumSqDev / n;
+  double* lowShare=  doubles_alloc( n );
+  for(  uint step= 0;  step < importanceSplitSteps;  ++step  ){
+    Gauss_params cluster[2];
+    for(  uint c= 0;  c < 2;  ++c  ){
+      cluster[c].mu=  mean[c];
+      cluster[c].sigma=  sqrt(  fmax( sumSqDev[c] / count[c], varianceFloor )  );
+    }
+    double newCount[2]=  {0.0, 0.0},  newMean[2]=  {0.0, 0.0},  newSumSqDev[2]=  {0.0, 0.0};
+    for(  uint i= 0;  i < n;  ++i  ){
+      double logRatio=  log( count[1] / count[0] )
+        +  GSLfun_ran_gaussian_logpdf( sorted[i], cluster[1] )  -  GSLfun_ran_gaussian_logpdf( sorted[i], cluster[0] );
+      lowShare[i]=  1.0 / (1.0 + exp( logRatio ));
+      newCount[0] +=  lowShare[i];
+      newMean[0]  +=  lowShare[i] * sorted[i];
+      newMean[1]  +=  (1.0 - lowShare[i]) * sorted[i];
+    }
+    newCount[1]=  n - newCount[0];
+    if(  newCount[0] < 1.0  ||  newCount[1] < 1.0  )   break;
+    for(  uint c= 0;  c < 2;  ++c  )   newMean[c] /= newCount[c];
+    for(  uint i= 0;  i < n;  ++i  ){
+      newSumSqDev[0] +=  lowShare[i]         * (sorted[i] - newMean[0]) * (sorted[i] - newMean[0]);
+      newSumSqDev[1] +=  (1.0 - lowShare[i]) * (sorted[i] - newMean[1]) * (sorted[i] - newMean[1]);
+    }
+    memcpy( count, newCount, sizeof(count) );
+    memcpy( mean, newMean, sizeof(mean) );
+    memcpy( sumSqDev, newSumSqDev, sizeof(sumSqDev) );
+  }
+
+  proposal.low=   component_proposal_make( count[0], mean[0], sumSqDev[0] );
+  proposal.high=  component_proposal_make( count[1], mean[1], sumSqDev[1] );
+  proposal.mixCof_low=   count[0] / importanceWiden  +  0.5;
+  proposal.mixCof_high=  count[1] / importanceWiden  +  0.5;
+  free( lowShare );
+  free( sorted );
+  return  proposal;
+}
+
+
+//  Proposal for one component:  prior, or pooled fit.
+LogMoments data_prob_1component_byImportance_chunk( const Dataset* data, const void* proposal_ptr, GSLfun_RNG* rng,
+                                                   uint begin, uint n ){
+  const importance_proposal* proposal= proposal_ptr;
+  const double logDefensive=  log( importanceDefensive );
+  const double logFitted=     log1p( -importanceDefensive );
+  LogMoments terms= LogMoments_empty;
+  for(  uint iter= 0;  iter < n;  ++iter  ){
+    double mu, precision;
+    if(  gsl_ran_flat01_r( rng ) < importanceDefensive  ){
+      Gauss_params params=  prior_Gauss_params_sample_r( rng );
+      mu=  params.mu;
+      precision=  1.0 / (params.sigma * params.sigma);
+    }
+    else{
+      component_proposal_sample_r( rng, &proposal->pooled, &mu, &precision );
+    }
+    double logPrior=  prior_Gauss_params_logpdf( mu, precision );
+    LogSumExp logProposal= LogSumExp_empty;
+    LogSumExp_add( &logProposal,  logDefensive + logPrior );
+    LogSumExp_add( &logProposal,  logFitted + component_proposal_logpdf( &proposal->pooled, mu, precision ) );
+
+    Gauss_params params=  {mu, sigma_of_precision( precision )};
+    LogMoments_add(  &terms,
+                    logPrior  +  data_summary_logLikelihood( &proposal->summary, params )  -  LogSumExp_log( logProposal )  );
+  }
+  return  terms;
+}
+
+double data_prob_1component_byImportance( const Dataset* data, GSLfun_RNG* rng, uint* samplesUsed ){
+  importance_proposal proposal=  importance_proposal_make( data );
+  return  sampling_logMean( data, rng, importanceSampleNum, data_prob_1component_byImportance_chunk, &proposal, samplesUsed );
+}
+
+
+//  Draw a component from one of the pooled, low, high and core fits, chosen with equal chance.
+void component_fits_sample_r( GSLfun_RNG* rng, const importance_proposal* proposal, double* mu, double* precision ){
+  const component_proposal* fits[4]=  {&proposal->pooled, &proposal->low, &proposal->high, &proposal->core};
+  uint fit=  (uint) (4.0 * gsl_ran_flat01_r( rng ));
+  component_proposal_sample_r( rng, fits[fit < 4?  fit : 3], mu, precision );
+}
+
+double component_fits_logpdf( const importance_proposal* proposal, double mu, double precision ){
+  LogSumExp density= LogSumExp_empty;
+  LogSumExp_add( &density,  component_proposal_logpdf( &proposal->pooled, mu, precision ) );
+  LogSumExp_add( &density,  component_proposal_logpdf( &proposal->low,    mu, precision ) );
+  LogSumExp_add( &density,  component_proposal_logpdf( &proposal->high,   mu, precision ) );
+  LogSumExp_add( &density,  component_proposal_logpdf( &proposal->core,   mu, precision ) );
+  return  LogSumExp_log( density ) - log( 4.0 );
+}
+
+
+/*  Proposal for two components, a mixture of the prior and, in equal parts,
+ *    both components drawn independently from the fits, with m from the Jeffreys prior,
+ *    which pairs e.g. a core with a wide halo fit to all the data;
+ *    one component from each side of the split, with m from the split's Beta;
+ *    one component from the fits and the other from the prior, with m from the Jeffreys prior,
+ *    for data mostly explained by one component, with the other unconstrained or catching outliers.
+ *  The last two choose which component is which with equal chance, so the proposal is symmetric like the posterior.
+ */
+LogMoments data_prob_2component_byImportance_chunk( const Dataset* data, const void* proposal_ptr, GSLfun_RNG* rng,
+                                                   uint begin, uint n ){
+  const importance_proposal* proposal= proposal_ptr;
+  const double logDefensive=  log( importanceDefensive );
+  const double logFitted=     log( (1.0 - importanceDefensive) / 3.0 );
+  const double logHalf=       log( 0.5 );
+  double* pdf1=  doubles_alloc( data->n );
+  double* pdf2=  doubles_alloc( data->n );
+  LogMoments terms= LogMoments_empty;
+  for(  uint iter= 0;  iter < n;  ++iter  ){
+    Gauss_mixture_params params=  prior_Gauss_mixture_params_sample_r( rng );
+    double mixCof=  params.mixCof;
+    double mu1=  params.Gauss1.mu,  precision1=  1.0 / (params.Gauss1.sigma * params.Gauss1.sigma);
+    double mu2=  params.Gauss2.mu,  precision2=  1.0 / (params.Gauss2.sigma * params.Gauss2.sigma);
+    double u=  gsl_ran_flat01_r( rng );
+    bool swap=  gsl_ran_flat01_r( rng ) < 0.5;
+    if(  u >= importanceDefensive  ){
+      switch(  (uint) (3.0 * (u - importanceDefensive) / (1.0 - importanceDefensive))  ){
+      case 0:
+        component_fits_sample_r( rng, proposal, &mu1, &precision1 );
+        component_fits_sample_r( rng, proposal, &mu2, &precision2 );
+        break;
+      case 1:
+        mixCof=  GSLfun_ran_beta_r( rng, proposal->mixCof_low, proposal->mixCof_high );
+        component_proposal_sample_r( rng, &proposal->low,  &mu1, &precision1 );
+        component_proposal_sample_r( rng, &proposal->high, &mu2, &precision2 );
+        if(  swap  ){
+          double t;
+          mixCof=  1.0 - mixCof;
+          t= mu1;  mu1= mu2;  mu2= t;
+          t= precision1;  precision1= precision2;  precision2= t;
+        }
+        break;
+      default:
+        if(  swap  )  component_fits_sample_r( rng, proposal, &mu2, &precision2 );
+        else          component_fits_sample_r( rng, proposal, &mu1, &precision1 );
+      }
+    }
+
+    double logPrior1=  prior_Gauss_params_logpdf( mu1, precision1 );
+    double logPrior2=  prior_Gauss_params_logpdf( mu2, precision2 );
+    double logFits1=  component_fits_logpdf( proposal, mu1, precision1 );
+    double logFits2=  component_fits_logpdf( proposal, mu2, precision2 );
+    double logJeffreys=  GSLfun_ran_beta_logpdf( mixCof, 0.5, 0.5 );
+    double logPrior=  logJeffreys + logPrior1 + logPrior2;
+
+    LogSumExp split= LogSumExp_empty;
+    LogSumExp_add( &split,
+                   GSLfun_ran_beta_logpdf( mixCof, proposal->mixCof_low, proposal->mixCof_high )
+                   +  component_proposal_logpdf( &proposal->low,  mu1, precision1 )
+                   +  component_proposal_logpdf( &proposal->high, mu2, precision2 ) );
+    LogSumExp_add( &split,
+                   GSLfun_ran_beta_logpdf( mixCof, proposal->mixCof_high, proposal->mixCof_low )
+                   +  component_proposal_logpdf( &proposal->high, mu1, precision1 )
+                   +  component_proposal_logpdf( &proposal->low,  mu2, precision2 ) );
+    LogSumExp lone= LogSumExp_empty;
+    LogSumExp_add( &lone,  logFits1 + logPrior2 );
+    LogSumExp_add( &lone,  logPrior1 + logFits2 );
+
+    LogSumExp logProposal= LogSumExp_empty;
+    LogSumExp_add( &logProposal,  logDefensive + logPrior );
+    LogSumExp_add( &logProposal,  logFitted + logJeffreys + logFits1 + logFits2 );
+    LogSumExp_add( &logProposal,  logFitted + logHalf + LogSumExp_log( split ) );
+    LogSumExp_add( &logProposal,  logFitted + logHalf + logJeffreys + LogSumExp_log( lone ) );
+
+    GSLfun_ran_gaussian_pdf_n_inv( pdf1, data->x, data->n, mu1, sqrt( precision1 ), -0.5 * log( precision1 ) );
+    GSLfun_ran_gaussian_pdf_n_inv( pdf2, data->x, data->n, mu2, sqrt( precision2 ), -0.5 * log( precision2 ) );
+    LogMoments_add(  &terms,
+                    logPrior  +  mixture_logLikelihood( data->n, mixCof, pdf1, pdf2 )  -  LogSumExp_log( logProposal )  );
+  }
+  free( pdf1 );
+  free( pdf2 );
+  return  terms;
+}
+
+double data_prob_2component_byImportance( const Dataset* data, GSLfun_RNG* rng, uint* samplesUsed ){
+  importance_proposal proposal=  importance_proposal_make( data );
+  return  sampling_logMean( data, rng, importanceSampleNum, data_prob_2component_byImportance_chunk, &proposal, samplesUsed );
+}
+
+
+
+/* ───────────  Adaptive Gaussian quadrature  ────────── */
+/*  Gauss rules weighted by the prior itself put nearly all their nodes where the likelihood is negligible,
+ *  since the likelihood is far narrower than the prior.  Instead each component's nodes are the union of
+ *  product rules, Gauss-Hermite for μ and generalized Gauss-Laguerre for the precision, fit to the prior and
+ *  to the pooled, low, high and core fits used for importance sampling.  Each node's weight is multiplied by
+ *  the prior density over the mixture of the fits' densities, so the rule still integrates over the prior.
+ *  mixCof uses Gauss-Jacobi nodes for the Jeffreys prior, whose weight function it is.
+ *  quad_nodes_n sets the number of nodes along each axis of each rule.
+ */
+
+// Density a component's nodes are placed by:  μ ~ N( mu.mu, mu.sigma ),  precision ~ Γ(shape,scale)
+typedef struct{
+  Gauss_params mu;
+  double shape;
+  double scale;
+} quadrature_fit;
+
+quadrature_fit quadrature_fit_of_proposal( const component_proposal* proposal ){
+  quadrature_fit fit=  {{proposal->mean,  sigma_of_precision( proposal->nEff * proposal->shape * proposal->scale )},
+                        proposal->shape,  proposal->scale};
+  return  fit;
+}
+
+double quadrature_fit_logpdf( const quadrature_fit* fit, double mu, double precision ){
+  return  GSLfun_ran_gaussian_logpdf( mu, fit->mu )  +  GSLfun_ran_gamma_logpdf( precision, fit->shape, fit->scale );
+}
+
+
+//  Copy the nodes of a GSL fixed rule to nodes[], and its weights, scaled to sum to 1, to weights[].
+void fixed_rule_copy( const gsl_integration_fixed_type* type, uint n, double a, double b, double alpha, double beta,
+                      double* nodes, double* weights ){
+  gsl_integration_fixed_workspace* fixed=  gsl_integration_fixed_alloc( type, n, a, b, alpha, beta );
+  if(  !fixed  ){
+    fprintf(  stderr, "Failed to set up a %u node fixed quadrature rule\n", n  );
+    exit( 70 );
+  }
+  const double* fixedNodes=    gsl_integration_fixed_nodes( fixed );
+  const double* fixedWeights=  gsl_integration_fixed_weights( fixed );
+  double total= 0.0;
+  for(  uint i= 0;  i < n;  ++i  )   total += fixedWeights[i];
+  for(  uint i= 0;  i < n;  ++i  ){
+    nodes[i]=    fixedNodes[i];
+    weights[i]=  fixedWeights[i] / total;
+  }
+  gsl_integration_fixed_free( fixed );
+}
+
+
+//  Return a quadrature rule adapted to data.
+prior_rule quadrature_rule_make( const Dataset* data ){
+  enum{ fitsN= 5 };
+  importance_proposal proposal=  importance_proposal_make( data );
+  quadrature_fit fits[fitsN]=  {{mu_prior_params, sigma_prior_param_a, sigma_prior_param_b},
+                                quadrature_fit_of_proposal( &proposal.pooled ),
+                                quadrature_fit_of_proposal( &proposal.low ),
+                                quadrature_fit_of_proposal( &proposal.high ),
+                                quadrature_fit_of_proposal( &proposal.core )};
+  uint n=  quad_nodes_n;
+  prior_rule rule;
+  prior_rule_alloc( &rule, fitsN * n * n, (n+1) / 2 );
+
+  double* nodes=  doubles_alloc( 2 * n );
+  double* weights=  doubles_alloc( 2 * n );
+  double* precision=  doubles_alloc( rule.components_n );
+  for(  uint f= 0;  f < fitsN;  ++f  ){
+    // Hermite weight  exp( -b(μ-a)² );  Laguerre weight  τ^α exp( -bτ )
+    fixed_rule_copy( gsl_integration_fixed_hermite, n,
+                     fits[f].mu.mu,  0.5 / (fits[f].mu.sigma * fits[f].mu.sigma),  0.0, 0.0,  nodes, weights );
+    fixed_rule_copy( gsl_integration_fixed_laguerre, n,
+                     0.0,  1.0 / fits[f].scale,  fits[f].shape - 1.0, 0.0,  nodes + n, weights + n );
+    for(  uint m= 0;  m < n;  ++m  ){
+      for(  uint s= 0;  s < n;  ++s  ){
+        uint c=  (f * n + m) * n + s;
+        rule.mu[c]=  nodes[m];
+        precision[c]=  nodes[n + s];
+        rule.sigma[c]=  sigma_of_precision( precision[c] );
+        rule.logWeight[c]=  log( weights[m] * weights[n + s] / fitsN );
+      }
+    }
+  }
+  for(  uint c= 0;  c < rule.components_n;  ++c  ){
+    LogSumExp fitsDensity= LogSumExp_empty;
+    for(  uint f= 0;  f < fitsN;  ++f  ){
+      LogSumExp_add(  &fitsDensity,  quadrature_fit_logpdf( &fits[f], rule.mu[c], precision[c] )  );
+    }
+    rule.logWeight[c] +=  prior_Gauss_params_logpdf( rule.mu[c], precision[c] )
+      -                   (LogSumExp_log( fitsDensity ) - log( fitsN ));
+  }
+
+  // The Jacobi nodes are symmetric about ½, and come in increasing order, so node i pairs with node n-1-i
+  fixed_rule_copy( gsl_integration_fixed_jacobi, n,  0.0, 1.0,  -0.5, -0.5,  nodes, weights );
+  for(  uint i= 0;  i < rule.JBeta_n;  ++i  ){
+    rule.JBeta[i]=  nodes[i];
+    rule.JBetaWeight[i]=  (i == n-1-i)?  weights[i]  :  2.0 * weights[i];
+  }
+  free( precision );
+  free( nodes );
+  free( weights );
+  return  rule;
+}
+
+double data_prob_1component_byQuadrature( const Dataset* data, GSLfun_RNG* unused, uint* unusedN ){
+  prior_rule rule=  quadrature_rule_make( data );
+  double logProb=  data_prob_1component_byRule( data, &rule );
+  prior_rule_free( &rule );
+  return  logProb;
+}
+
+double data_prob_2component_byQuadrature( const Dataset* data, GSLfun_RNG* unused, uint* unusedN ){
+  prior_rule rule=  quadrature_rule_make( data );
+  double logProb=  data_prob_2component_byRule( data, &rule );
+  prior_rule_free( &rule );
+  return  logProb;
+}
+
+
+
+/* ───────────  Sparse grid (Smolyak) integration  ────────── */
+/*  The combination technique sums tensor products of 1-D rules with levels l₁..l_d, over
+ *  L ≦ |l| ≦ L+d-1, with signed coefficients (-1)^(L+d-1-|l|) C(d-1, L+d-1-|l|).
+ *  This keeps the accuracy of the full tensor rule of level L for functions that are sums of
+ *  low dimensional parts, with about 2ᴸ Lᵈ⁻¹ instead of 2ᴸᵈ points.
+ *  The 1-D rule of level l is the quantile rule with nodes k/2ˡ, k= 1..2ˡ-1, equally weighted,
+ *  like the cdfInv grids.  The rules are nested, so each axis's coordinates are tabulated once at level L.
+ *  The signed terms can cancel to a total ≦ 0 when the levels are too coarse for the integrand;
+ *  the estimate is then NaN, and the dataset is left out of the method's tally.
+ *  The default level 9 is the lowest at which that rarely happens for the 5-D two-component integral,
+ *  which then needs about 1.1M points, more than the summing grid; the 2-D pooled grid needs about 10k.
+ */
+uint smolyakLevel= 9;
+
+#define CUBE_DIM_MAX 16
+
+// Integrand over the unit cube, for the sparse grid and adaptive integrators.
+// Integrand  exp( logf(x) ), with each coordinate  x[i]= coordinate_of_u( i, u[i], context )  for u in the unit cube.
+typedef struct{
+  uint dim;
+  double (*coordinate_of_u)( uint axis, double u, const void* context );
+  double (*logf)( const double* x, void* context );
+  void* context;
+} cube_integrand;
+
+double binomial( uint n, uint k ){
+  double c= 1.0;
+  for(  uint i= 1;  i <= k;  ++i  )   c=  c * (n - k + i) / i;
+  return  c;
+}
+
+//  Log of the sum of f over the tensor product of the level l[i] rules, each weighted 1/(2^l[i] - 1).
+double smolyak_tensor_logSum( const cube_integrand* f, const double* table, uint level, const uint* l ){
+  uint d=  f->dim;
+  uint finestN=  (1u << level) - 1;
+  uint k[CUBE_DIM_MAX];
+  double x[CUBE_DIM_MAX];
+  double logWeight= 0.0;
+  for(  uint i= 0;  i < d;  ++i  ){
+    k[i]= 1;
+    x[i]=  table[i * finestN  +  (1u << (level - l[i])) - 1];
+    logWeight -=  log( (double) ((1u << l[i]) - 1) );
+  }
+  LogSumExp sum= LogSumExp_empty;
+  for(;;){
+    LogSumExp_add(  &sum,  f->logf( x, f->context )  );
+    // Advance k like an odometer over k[i] ∈ 1..2^l[i]-1
+    uint i= 0;
+    for(  ;  i < d;  ++i  ){
+      k[i] +=  1;
+      if(  k[i] < (1u << l[i])  )   break;
+      k[i]=  1;
+    }
+    if(  i == d  )   break;
+    for(  uint j= 0;  j <= i;  ++j  ){
+      x[j]=  table[j * finestN  +  (k[j] << (level - l[j])) - 1];
+    }
+  }
+  return  LogSumExp_log( sum ) + logWeight;
+}
+
+//  Returns the log of the integral of f over the unit cube, by the level L sparse grid.
+double smolyak_logIntegral( const cube_integrand* f, uint level ){
+  uint d=  f->dim;
+  uint finestN=  (1u << level) - 1;
+  double* table=  doubles_alloc( (size_t) d * finestN );
+  for(  uint i= 0;  i < d;  ++i  ){
+    for(  uint k= 1;  k <= finestN;  ++k  ){
+      table[i * finestN + k-1]=  f->coordinate_of_u(  i,  k / (double) (1u << level),  f->context  );
+    }
+  }
+
+  LogSumExp positive= LogSumExp_empty,  negative= LogSumExp_empty;
+  uint l[CUBE_DIM_MAX];
+  for(  uint q= (level > d? level : d);  q <= level + d - 1;  ++q  ){
+    uint skip=  level + d - 1 - q;
+    double logCoefficient=  log( binomial( d-1, skip ) );
+    LogSumExp* total=  (skip % 2)?  &negative : &positive;
+    // Visit every l with l[i] ≧ 1 and |l| = q, choosing l[0..d-2] freely and l[d-1] to make up q
+    for(  uint i= 0;  i < d;  ++i  )   l[i]= 1;
+    for(;;){
+      uint lowerSum= 0;
+      for(  uint i= 0;  i+1 < d;  ++i  )   lowerSum += l[i];
+      if(  lowerSum < q  &&  q - lowerSum <= level  ){
+        l[d-1]=  q - lowerSum;
+        LogSumExp_add(  total,  logCoefficient  +  smolyak_tensor_logSum( f, table, level, l )  );
+      }
+      uint i= 0;
+      for(  ;  i+1 < d;  ++i  ){
+        if(  ++l[i] <= level  )   break;
+        l[i]= 1;
+      }
+      if(  i+1 >= d  )   break;
+    }
+  }
+  free( table );
+
+  double logPositive=  LogSumExp_log( positive ),  logNegative=  LogSumExp_log( negative );
+  if(  logNegative >= logPositive  )   return  NAN;
+  return  logPositive  +  log1p( -exp( logNegative - logPositive ) );
+}
+
+
+//  The sparse grid lives in the unit cube of an envelope density centred on the data:
+//  for each component  μ ~ N( data mean, envelopeWidth × data sd ),  precision ~ Γ( ½, envelopeWidth² / data variance ),
+//  independently, and mixCof ~ Beta(½,½) as in the prior.  The integrand is weighted by prior over envelope density.
+//  Under the prior, nearly all of the unit cube maps to parameters far from the data.
+const double envelopeWidth= 2.0;
+
+typedef struct{
+  Gauss_params mu;
+  double shape;
+  double scale;
+} sparse_grid_envelope;
+
+sparse_grid_envelope sparse_grid_envelope_make( const data_summary* summary ){
+  double variance=  fmax( summary->sumSqDev / summary->n,  1e-6 );
+  sparse_grid_envelope envelope=  {{summary->mean,  envelopeWidth * sqrt( variance )},
+                                   0.5,  envelopeWidth * envelopeWidth / variance};
+  return  envelope;
+}
+
+double sparse_grid_envelope_logWeight( const sparse_grid_envelope* envelope, double mu, double precision ){
+  return  prior_Gauss_params_logpdf( mu, precision )
+    -     GSLfun_ran_gaussian_logpdf( mu, envelope->mu )
+    -     GSLfun_ran_gamma_logpdf( precision, envelope->shape, envelope->scale );
+}
+
+//  Coordinates are (μ, precision) pairs, preceded by mixCof for mixtures.
+double sparse_grid_envelope_coordinate( const sparse_grid_envelope* envelope, uint axis, double u ){
+  switch(  axis % 2  ){
+  case 0:   return  envelope->mu.mu  +  gsl_cdf_gaussian_Pinv( u, envelope->mu.sigma );
+  default:  return  gsl_cdf_gamma_Pinv( u, envelope->shape, envelope->scale );
+  }
+}
+
+// Data and scratch space for the cube integrands; envelope is only used by the sparse grid.
+typedef struct{
+  sparse_grid_envelope envelope;
+  data_summary summary;
+  const Dataset* data;
+  double* pdf1;
+  double* pdf2;
+} cube_context;
+
+double data_1component_coordinate( uint axis, double u, const void* context ){
+  return  sparse_grid_envelope_coordinate( &((const cube_context*) context)->envelope,  axis,  u );
+}
+
+double data_2component_coordinate( uint axis, double u, const void* context ){
+  if(  axis == 0  )   return  prior_mixCof_of_u( u );
+  return  sparse_grid_envelope_coordinate( &((const cube_context*) context)->envelope,  axis - 1,  u );
+}
+
+double data_logLikelihood_1component_x( const double* x, void* context_ptr ){
+  cube_context* context= context_ptr;
+  Gauss_params params=  {x[0], sigma_of_precision( x[1] )};
+  return  data_summary_logLikelihood( &context->summary, params )
+    +     sparse_grid_envelope_logWeight( &context->envelope, x[0], x[1] );
+}
+
+double data_logLikelihood_2component_x( const double* x, void* context_ptr ){
+  cube_context* context= context_ptr;
+  Gauss_mixture_params params=  {x[0],  {x[1], sigma_of_precision( x[2] )},  {x[3], sigma_of_precision( x[4] )}};
+  return  data_logLikelihood_2component( context->data, params, context->pdf1, context->pdf2 )
+    +     sparse_grid_envelope_logWeight( &context->envelope, x[1], x[2] )
+    +     sparse_grid_envelope_logWeight( &context->envelope, x[3], x[4] );
+}
+
+double data_prob_1component_bySparseGrid( const Dataset* data, GSLfun_RNG* unused, uint* unusedN ){
+  cube_context context=  {.summary= data_summarize( data ),  .data= data};
+  context.envelope=  sparse_grid_envelope_make( &context.summary );
+  cube_integrand f=  {2,  data_1component_coordinate,  data_logLikelihood_1component_x,  &context};
+  return  smolyak_logIntegral( &f, smolyakLevel );
+}
+
+double data_prob_2component_bySparseGrid( const Dataset* data, GSLfun_RNG* unused, uint* unusedN ){
+  cube_context context=  {.summary= data_summarize( data ),  .data= data,
+                                 .pdf1= doubles_alloc( data->n ),  .pdf2= doubles_alloc( data->n )};
+  context.envelope=  sparse_grid_envelope_make( &context.summary );
+  cube_integrand f=  {5,  data_2component_coordinate,  data_logLikelihood_2component_x,  &context};
+  double logProb=  smolyak_logIntegral( &f, smolyakLevel );
+  free( context.pdf1 );
+  free( context.pdf2 );
+  return  logProb;
+}
+
+
+
+/* ───────────  Adaptive subdivision of the prior's unit cube  ────────── */
+/*  Start from a coarse grid of cells in the u coordinates of the cdfInv grids, adaptiveStartN per axis,
+ *  and repeatedly split the cell with the largest estimated error, kept at the top of a heap, until
+ *  adaptiveEvalNum integrand evaluations have been used.
+ *  Each cell is evaluated at its center and at the centers of the halves it would be split into along
+ *  each axis.  The axis where the halves' mean differs most from the center is the one to split, that difference
+ *  times the volume is the cell's error, and the halves' mean times the volume its estimate.
+ *  After a split each child's center is already known, so a split costs 4d evaluations.
+ *  A posterior narrower than a cell can fall between its probes, so that the difference is near zero;
+ *  every cell's error is therefore at least its volume times e^logAdaptiveErrorFloor times the largest value
+ *  of the integrand seen so far, and the heap is re-keyed whenever that value rises by a factor e.
+ *  As in the Riemann sums, mixCof only ranges over ≦ ½, covering 1-mixCof by symmetry.
+ */
+uint adaptiveEvalNum= 100000;
+uint adaptiveStartN= 3;
+const double logAdaptiveErrorFloor= -10.0;  // Relative to the largest value of the integrand seen
+
+typedef struct{
+  double lo[CUBE_DIM_MAX];
+  double width[CUBE_DIM_MAX];
+  double logCenter;            // log f at the center
+  double logHalf[2];           // log f at the centers of the two halves along splitAxis
+  uint splitAxis;
+  double logEstimate;
+  double logVolume;
+  double logDiff;              // Difference between the halves' mean and the center, per unit volume
+  double logError;
+} adaptive_cell;
+
+// Max-heap of cells by logError
+typedef struct{
+  adaptive_cell* cells;
+  size_t n;
+  size_t capacity;
+} cell_heap;
+
+void cell_heap_push( cell_heap* heap, const adaptive_cell* cell ){
+  if(  heap->n == heap->capacity  ){
+    heap->capacity=  heap->capacity?  2 * heap->capacity : 1024;
+    heap->cells=  realloc( heap->cells, heap->capacity * sizeof(adaptive_cell) );
+    if(  !heap->cells  ){
+      fprintf( stderr, "Failed to allocate %zu cells\n", heap->capacity );
+      exit( 1 );
+    }
+  }
+  size_t i=  heap->n++;
+  while(  i > 0  &&  heap->cells[(i-1)/2].logError < cell->logError  ){
+    heap->cells[i]=  heap->cells[(i-1)/2];
+    i=  (i-1) / 2;
+  }
+  heap->cells[i]=  *cell;
+}
+
+//  Set each cell's error to its volume times the larger of its own difference and exp( logFloor ),
+//  and restore the heap order.
+void cell_heap_rekey( cell_heap* heap, double logFloor ){
+  size_t n=  heap->n;
+  heap->n= 0;
+  for(  size_t c= 0;  c < n;  ++c  ){
+    adaptive_cell cell=  heap->cells[c];
+    cell.logError=  cell.logVolume  +  fmax( cell.logDiff, logFloor );
+    cell_heap_push( heap, &cell );
+  }
+}
+
+adaptive_cell cell_heap_pop( cell_heap* heap ){
+  adaptive_cell top=  heap->cells[0];
+  adaptive_cell last=  heap->cells[--heap->n];
+  size_t i= 0;
+  for(;;){
+    size_t child=  2*i + 1;
+    if(  child >= heap->n  )   break;
+    if(  child+1 < heap->n  &&  heap->cells[child+1].logError > heap->cells[child].logError  )   ++child;
+    if(  heap->cells[child].logError <= last.logError  )   break;
+    heap->cells[i]=  heap->cells[child];
+    i=  child;
+  }
+  if(  heap->n  )   heap->cells[i]=  last;
+  return  top;
+}
+
+double cube_integrand_logf_u( const cube_integrand* f, const double* u ){
+  double x[CUBE_DIM_MAX];
+  for(  uint i= 0;  i < f->dim;  ++i  )   x[i]=  f->coordinate_of_u( i, u[i], f->context );
+  return  f->logf( x, f->context );
+}
+
+//  log |exp(a) - exp(b)|
+double logAbsDiff( double a, double b ){
+  double max=  fmax( a, b ),  min=  fmin( a, b );
+  if(  max == -INFINITY  )   return  -INFINITY;
+  return  max  +  log1p( -exp( min - max ) );
+}
+
+//  Given cell->lo, width and logCenter, evaluate the halves along each axis and fill in the rest of cell,
+//  with an error of at least its volume times exp( logFloor ).
+void adaptive_cell_evaluate( const cube_integrand* f, adaptive_cell* cell, double logFloor ){
+  double x[CUBE_DIM_MAX];    // Coordinates of the center, except along the axis being probed
+  double logVolume= 0.0;
+  for(  uint i= 0;  i < f->dim;  ++i  ){
+    x[i]=  f->coordinate_of_u(  i,  cell->lo[i] + 0.5 * cell->width[i],  f->context  );
+    logVolume +=  log( cell->width[i] );
+  }
+  double logDiffMax= -INFINITY;
+  cell->splitAxis= 0;
+  for(  uint i= 0;  i < f->dim;  ++i  ){
+    double xCenter=  x[i];
+    double logHalf[2];
+    for(  uint h= 0;  h < 2;  ++h  ){
+      x[i]=  f->coordinate_of_u(  i,  cell->lo[i] + (0.25 + 0.5*h) * cell->width[i],  f->context  );
+      logHalf[h]=  f->logf( x, f->context );
+    }
+    x[i]=  xCenter;
+    LogSumExp halves= LogSumExp_empty;
+    LogSumExp_add( &halves, logHalf[0] );
+    LogSumExp_add( &halves, logHalf[1] );
+    double logMean=  LogSumExp_log( halves ) - log( 2.0 );
+    double logDiff=  logAbsDiff( logMean, cell->logCenter );
+    if(  i == 0  ||  logDiff > logDiffMax  ){
+      logDiffMax=  logDiff;
+      cell->splitAxis=  i;
+      cell->logHalf[0]=  logHalf[0];
+      cell->logHalf[1]=  logHalf[1];
+      cell->logEstimate=  logVolume + logMean;
+    }
+  }
+  cell->logVolume=  logVolume;
+  cell->logDiff=  logDiffMax;
+  cell->logError=  logVolume  +  fmax( logDiffMax, logFloor );
+}
+
+//  Returns the log of the integral of f over the box  [0,extent[0]] × … × [0,extent[d-1]].
+double adaptive_logIntegral( const cube_integrand* f, const double* extent, uint startN, uint evalNum ){
+  uint d=  f->dim;
+  cell_heap heap=  {NULL, 0, 0};
+  uint k[CUBE_DIM_MAX];
+  double u[CUBE_DIM_MAX]= {0};
+  ulong evalsUsed= 0;
+  double logMax= -INFINITY;         // Largest value of f seen so far
+  double logFloor= -INFINITY;       // Error floor per unit volume the heap is ordered by
+  adaptive_cell cell;
+  for(  uint i= 0;  i < d;  ++i  ){
+    k[i]= 0;
+    cell.width[i]=  extent[i] / startN;
+  }
+  for(;;){
+    for(  uint i= 0;  i < d;  ++i  ){
+      cell.lo[i]=  k[i] * cell.width[i];
+      u[i]=  cell.lo[i]  +  0.5 * cell.width[i];
+    }
+    cell.logCenter=  cube_integrand_logf_u( f, u );
+    adaptive_cell_evaluate( f, &cell, logFloor );
+    evalsUsed +=  1 + 2*d;
+    logMax=  fmax(  logMax,  fmax( cell.logCenter, fmax( cell.logHalf[0], cell.logHalf[1] ) )  );
+    cell_heap_push( &heap, &cell );
+    uint i= 0;
+    for(  ;  i < d;  ++i  ){
+      if(  ++k[i] < startN  )   break;
+      k[i]= 0;
+    }
+    if(  i == d  )   break;
+  }
+
+  while(  evalsUsed + 4*d <= evalNum  ){
+    if(  logMax > logFloor - logAdaptiveErrorFloor + 1.0  ){
+      logFloor=  logMax + logAdaptiveErrorFloor;
+      cell_heap_rekey( &heap, logFloor );
+    }
+    if(  heap.cells[0].logError == -INFINITY  )   break;
+    adaptive_cell parent=  cell_heap_pop( &heap );
+    uint a=  parent.splitAxis;
+    for(  uint h= 0;  h < 2;  ++h  ){
+      adaptive_cell child=  parent;
+      child.width[a]=  0.5 * parent.width[a];
+      child.lo[a]=  parent.lo[a]  +  h * child.width[a];
+      child.logCenter=  parent.logHalf[h];
+      adaptive_cell_evaluate( f, &child, logFloor );
+      logMax=  fmax(  logMax,  fmax( child.logHalf[0], child.logHalf[1] )  );
+      cell_heap_push( &heap, &child );
+    }
+    evalsUsed +=  4*d;
+  }
+
+  LogSumExp total= LogSumExp_empty;
+  for(  size_t c= 0;  c < heap.n;  ++c  )   LogSumExp_add( &total, heap.cells[c].logEstimate );
+  free( heap.cells );
+  return  LogSumExp_log( total );
+}
+
+
+double prior_1component_coordinate( uint axis, double u, const void* unused ){
+  return  (axis == 0)?  prior_mu_of_u( u ) : prior_sigma_of_u( u );
+}
+
+double prior_2component_coordinate( uint axis, double u, const void* unused ){
+  if(  axis == 0  )   return  prior_mixCof_of_u( u );
+  return  prior_1component_coordinate( (axis-1) % 2, u, unused );
+}
+
+double data_logLikelihood_1component_prior_x( const double* x, void* context_ptr ){
+  cube_context* context= context_ptr;
+  Gauss_params params=  {x[0], x[1]};
+  return  data_summary_logLikelihood( &context->summary, params );
+}
+
+double data_logLikelihood_2component_prior_x( const double* x, void* context_ptr ){
+  cube_context* context= context_ptr;
+  Gauss_mixture_params params=  {x[0],  {x[1], x[2]},  {x[3], x[4]}};
+  return  data_logLikelihood_2component( context->data, params, context->pdf1, context->pdf2 );
+}
+
+double data_prob_1component_byAdaptive( const Dataset* data, GSLfun_RNG* unused, uint* unusedN ){
+  cube_context context=  {.summary= data_summarize( data ),  .data= data};
+  cube_integrand f=  {2,  prior_1component_coordinate,  data_logLikelihood_1component_prior_x,  &context};
+  const double extent[]= {1.0, 1.0};
+  return  adaptive_logIntegral( &f, extent, adaptiveStartN, adaptiveEvalNum );
+}
+
+double data_prob_2component_byAdaptive( const Dataset* data, GSLfun_RNG* unused, uint* unusedN ){
+  cube_context context=  {.data= data,  .pdf1= doubles_alloc( data->n ),  .pdf2= doubles_alloc( data->n )};
+  cube_integrand f=  {5,  prior_2component_coordinate,  data_logLikelihood_2component_prior_x,  &context};
+  const double extent[]= {0.5, 1.0, 1.0, 1.0, 1.0};
+  double logProb=  log( 2.0 )  +  adaptive_logIntegral( &f, extent, adaptiveStartN, adaptiveEvalNum );
+  free( context.pdf1 );
+  free( context.pdf2 );
+  return  logProb;
+}
+
+
+
+/* ───────────  Driver evaluating many datasets in parallel  ────────── */
+
+// Ways to estimate the log marginal likelihood of data under each model.
+// Sampled ones also set *samplesUsed; deterministic ones ignore rng and samplesUsed.
+typedef struct{
+  const char* name;
+  bool sampled;
+  double (*prob_1component)( const Dataset* data, GSLfun_RNG* rng, uint* samplesUsed );
+  double (*prob_2component)( const Dataset* data, GSLfun_RNG* rng, uint* samplesUsed );
+} integration_method;
+
+const integration_method methods[]= {
+  {"sampling",   true,   data_prob_1component_bySampling,    data_prob_2component_bySampling},
+  {"summing",    false,  data_prob_1component_bySumming,     data_prob_2component_bySumming},
+  {"importance", true,   data_prob_1component_byImportance,  data_prob_2component_byImportance},
+  {"qmc",        true,   data_prob_1component_byQMC,         data_prob_2component_byQMC},
+  {"quadrature", false,  data_prob_1component_byQuadrature,  data_prob_2component_byQuadrature},
+  {"sparsegrid", false,  data_prob_1component_bySparseGrid,  data_prob_2component_bySparseGrid},
+  {"adaptive",   false,  data_prob_1component_byAdaptive,    data_prob_2component_byAdaptive},
+};
+#define METHODS_N  (sizeof(methods) / sizeof(methods[0]))
+
+// Indices into methods of those to run, in the order given on the command line
+uint methodsUsed[METHODS_N];
+uint methodsUsedN= 0;
+
+//  Select the methods named in comma separated list.  Return false if a name is unknown.
+bool methods_select( const char* list ){
+  methodsUsedN= 0;
+  for(  const char* name= list;  *name;  ){
+    size_t len=  strcspn( name, "," );
+    uint method= 0;
+    while(  method < METHODS_N  &&  (strlen( methods[method].name ) != len  ||  strncmp( methods[method].name, name, len ))  ){
+      ++method;
+    }
+    if(  method == METHODS_N  ||  methodsUsedN == METHODS_N  )   return  false;
+    methodsUsed[methodsUsedN++]=  method;
+    name += len;
+    if(  *name  )   ++name;
+  }
+  return  methodsUsedN > 0;
+}
+
+
+// Everything reported about one dataset
+typedef struct{
+  Gauss_mixture_params model_params;  // Only Gauss1 is used for data generated with one component
+  // Log marginal likelihoods of the data under each model, indexed like methodsUsed
+  double prob_data1[METHODS_N];
+  double prob_data2[METHODS_N];
+  uint samples_data1[METHODS_N];  // Samples used by sampled methods
+  uint samples_data2[METHODS_N];
+  double prob_data1_exact;
+} dataset_result;
+
+
+//  Generate dataset number iter from a model with the given number of components, and integrate over both models.
+//  Everything random, except a shared priorBank, is drawn from a stream numbered by (components, iter),
+//  and each method draws from its own child of that stream,
+//  so the result does not depend on which thread evaluates it or when, nor on which other methods run.
+void dataset_evaluate( uint components, uint iter, Dataset* data, dataset_result* result ){
+  ulong stream=  GSLfun_stream_child( components == 1?  STREAM_DATA_1COMPONENT : STREAM_DATA_2COMPONENT, iter );
+  GSLfun_RNG* rng=  GSLfun_RNG_alloc( stream );
+
+  if(  components == 1  ){
+    result->model_params.Gauss1=  prior_Gauss_params_sample_r( rng );
+    data_generate_1component( data, rng, result->model_params.Gauss1 );
+  }
+  else{
+    result->model_params=  prior_Gauss_mixture_params_sample_r( rng );
+    data_generate_2component( data, rng, result->model_params );
+  }
+  GSLfun_RNG_free( rng );
+
+  for(  uint m= 0;  m < methodsUsedN;  ++m  ){
+    const integration_method* method=  &methods[methodsUsed[m]];
+    GSLfun_RNG* method_rng=  GSLfun_RNG_alloc(  GSLfun_stream_child( stream, 1 + methodsUsed[m] )  );
+    result->prob_data1[m]=  method->prob_1component( data, method_rng, &result->samples_data1[m] );
+    result->prob_data2[m]=  method->prob_2component( data, method_rng, &result->samples_data2[m] );
+    GSLfun_RNG_free( method_rng );
+  }
+  result->prob_data1_exact=  data_prob_1component_exact( data );
+}
+
+
+//  Print the log integrals in result, and count for each method whether it favors the pooled model,
+//  or whether it failed to estimate either integral.
+void dataset_result_print( const dataset_result* result, uint favors1[], uint failed[] ){
+  printf( "Log integrals" );
+  for(  uint m= 0;  m < methodsUsedN;  ++m  ){
+    printf(  "  by %s: (%g,%g)", methods[methodsUsed[m]].name, result->prob_data1[m], result->prob_data2[m]  );
+    if(  methods[methodsUsed[m]].sampled  &&  (sampleTolerance > 0.0  ||  sampleTimeBudget > 0.0)  ){
+      printf(  " using (%u,%u) samples", result->samples_data1[m], result->samples_data2[m]  );
+    }
+    if(  isnan( result->prob_data1[m] )  ||  isnan( result->prob_data2[m] )  ){
+      printf( " failed" );
+      ++failed[m];
+    }
+    else if(  result->prob_data1[m] > result->prob_data2[m]  )   ++favors1[m];
+  }
+  printf(  "  pooled exact: %g\n\n", result->prob_data1_exact  );
+}
+
+
+// Work shared between the dataset worker threads and the thread printing their results.
+// Task t < datasets_n is data generated with one component, the rest with two.
+typedef struct{
+  uint datasets_n;
+  uint tasks_n;
+  atomic_uint next;
+  dataset_result* results;
+  bool* done;
+  pthread_mutex_t lock;
+  pthread_cond_t  finished;
+} dataset_job;
+
+void* dataset_worker( void* job_ptr ){
+  dataset_job* job= job_ptr;
+  Dataset data=  {doubles_alloc( dataN ), dataN};
+  for(  uint t;  (t= atomic_fetch_add( &job->next, 1 )) < job->tasks_n;  ){
+    uint components=  (t < job->datasets_n)?  1 : 2;
+    dataset_evaluate( components, t % job->datasets_n, &data, &job->results[t] );
+    pthread_mutex_lock( &job->lock );
+    job->done[t]=  true;
+    pthread_cond_broadcast( &job->finished );
+    pthread_mutex_unlock( &job->lock );
+  }
+  free( data.x );
+  return  NULL;
+}
+
+//  Wait until task t of job has been evaluated, and return its result.
+const dataset_result* dataset_result_wait( dataset_job* job, uint t ){
+  pthread_mutex_lock( &job->lock );
+  while(  !job->done[t]  )   pthread_cond_wait( &job->finished, &job->lock );
+  pthread_mutex_unlock( &job->lock );
+  return  &job->results[t];
+}
+
+
+
+/* ───────────  Self checks, run at startup unless compiled with NDEBUG  ────────── */
+#ifndef NDEBUG
+
+//  40 data for N(0,1) components: 39 clustered near 4, with densities about 2⁻¹³, and one outlier at -33.
+//  Just before the outlier's e⁻⁵⁴⁵ factor, the product of the others has come down to about 2⁻⁵⁰⁰.
+Dataset check_outlying_data(){
+  Dataset data=  {doubles_alloc( 40 ), 40};
+  for(  uint d= 0;  d < 39;  ++d  )   data.x[d]=  4.0 + 0.01 * ((int) d - 19);
+  data.x[39]=  -33.0;
+  return  data;
+}
+
+//  Products of densities kept as mantissa and exponent must match the plain sum of log densities.
+void self_check_scaledProd(){
+  Dataset data=  check_outlying_data();
+  Gauss_params standard=  {0.0, 1.0};
+  double* pdf=  doubles_alloc( data.n );
+  GSLfun_ran_gaussian_pdf_n( pdf, data.x, data.n, standard );
+  double logSum=  GSLfun_ran_gaussian_logpdf_sum( data.x, data.n, standard );
+
+  double curProb= 1.0;  int curExpo= 0;
+  for(  uint d= 0;  d < data.n;  ++d  )   scaledProd_mul( &curProb, &curExpo, pdf[d] );
+  assert(  fabs( scaledProd_log( curProb, curExpo ) - logSum )  <  1e-9 * fabs( logSum )  );
+  assert(  fabs( mixture_logLikelihood( data.n, 0.3, pdf, pdf ) - logSum )  <  1e-9 * fabs( logSum )  );
+  free( pdf );
+  free( data.x );
+}
+
+//  Skipping negligible terms of the pair sum must change it by no more than a fraction pruneTolerance,
+//  even on data far out in the prior's tails:  40 data, one at 120 and the others alternating at ±37.5.
+//  The likelihood bounds of the best pairs pass below 2⁻⁵⁰⁰ on their way to the outlier's factor.
+void self_check_pruning(){
+  Dataset data=  {doubles_alloc( 40 ), 40};
+  data.x[0]=  120.0;
+  for(  uint d= 1;  d < data.n;  ++d  )   data.x[d]=  (d % 2)?  37.5 : -37.5;
+  prior_rule rule;
+  prior_rule_quantiles( &rule, 8, 5, 6 );
+  double savedTolerance=  pruneTolerance;
+  pruneTolerance=  0.0;
+  double logAll=  data_prob_2component_byRule( &data, &rule );
+  pruneTolerance=  1e-6;
+  double logPruned=  data_prob_2component_byRule( &data, &rule );
+  pruneTolerance=  savedTolerance;
+  assert(  logPruned < logAll + 1e-9  &&  logPruned > logAll + log1p( -1e-6 ) - 1e-9  );
+  prior_rule_free( &rule );
+  free( data.x );
+}
+
+//  The adaptive integrator must find a posterior narrower than its start cells' probe spacing:
+//  40 data spread like N(-8.14, 0.45²), whose posterior sits in a corner of the prior's unit cube.
+void self_check_adaptive_narrow(){
+  Dataset data=  {doubles_alloc( 40 ), 40};
+  for(  uint d= 0;  d < data.n;  ++d  )   data.x[d]=  -8.14  +  gsl_cdf_gaussian_Pinv( (d + 0.5) / data.n, 0.45 );
+  uint savedEvalNum=  adaptiveEvalNum;
+  adaptiveEvalNum=  20000;
+  double logAdaptive=  data_prob_1component_byAdaptive( &data, NULL, NULL );
+  adaptiveEvalNum=  savedEvalNum;
+  assert(  fabs( logAdaptive - data_prob_1component_exact( &data ) )  <  0.1  );
+  free( data.x );
+}
+
+void self_checks(){
+  self_check_scaledProd();
+  self_check_pruning();
+  self_check_adaptive_narrow();
+}
+
+#endif
+
+
+
+/* Checkpoints, so an interrupted run can resume where it stopped.
+ * Every dataset draws from its own stream, so resuming needs only the number of datasets already reported
+ * and the tallies so far; nothing is drawn from the global generator.  The configuration is saved too,
+ * so a checkpoint is not resumed under different settings.
+ * Each checkpoint is written to a temporary file which then replaces the old one, so a crash never leaves half a checkpoint.
+ */
+#define CHECKPOINT_HEADER "Gaussian_poolOrNot checkpoint 3\n"
+
+typedef struct{
+  uint next;                      // Index of the first task not yet reported
+  uint model1_favors1[METHODS_N];
+  uint model2_favors1[METHODS_N];
+  uint model1_failed[METHODS_N];
+  uint model2_failed[METHODS_N];
+} checkpoint_state;
+
+void checkpoint_write( const char* path, const char* config, const checkpoint_state* state ){
+  fflush( stdout );    // Results reported so far must not be lost once the checkpoint says they were reported
+  char tmpPath[strlen( path ) + 5];
+  sprintf( tmpPath, "%s.tmp", path );
+  FILE* file=  fopen( tmpPath, "w" );
+  bool ok=  file != NULL;
+  if(  ok  ){
+    fprintf( file, CHECKPOINT_HEADER "%s\n%u\n", config, state->next );
+    for(  uint m= 0;  m < methodsUsedN;  ++m  ){
+      fprintf( file, "%u %u %u %u\n", state->model1_favors1[m], state->model2_favors1[m],
+                                     state->model1_failed[m],  state->model2_failed[m] );
+    }
+    ok=  !fflush( file )  &&  !fsync( fileno( file ) );
+    ok=  !fclose( file )  &&  ok;
+  }
+  if(  !ok  ||  rename( tmpPath, path )  ){
+    perror( path );
+    exit( 74 );
+  }
+}
+
+//  Append to config, of length len and capacity size, the arguments argv[1..argc-1] as parsed with optstring,
+//  leaving out the options in unsaved with their arguments.  Return the new length.
+int config_append_args( char* config, size_t size, int len, int argc, char* argv[],
+                        const char* optstring, const char* unsaved ){
+  for(  int a= 1;  a < argc  &&  len < (int) size;  ++a  ){
+    const char* arg=  argv[a];
+    if(  arg[0] != '-'  ||  !arg[1]  ||  !strcmp( arg, "--" )  ){
+      len +=  snprintf( config + len, size - len, " %s", arg );
+      continue;
+    }
+    // Options clustered in one argument, the last of them possibly followed by its argument
+    char kept[strlen( arg ) + 1];
+    uint keptLen= 0;
+    const char* value=  NULL;
+    for(  const char* c= arg + 1;  *c;  ++c  ){
+      const char* spec=  strchr( optstring, *c );
+      bool takesArg=  spec  &&  spec[1] == ':';
+      if(  !strchr( unsaved, *c )  ){
+        kept[keptLen++]=  *c;
+        if(  takesArg  )   value=  c[1]?  c + 1 : (a + 1 < argc)?  argv[a+1] : "";
+      }
+      if(  takesArg  ){    // The rest of this argument, or else the next one, is the option's argument
+        if(  !c[1]  )   ++a;
+        break;
+      }
+    }
+    kept[keptLen]=  '\0';
+    if(  keptLen  )   len +=  snprintf( config + len, size - len, " -%s", kept );
+    if(  value  )     len +=  snprintf( config + len, size - len, " %s", value );
+  }
+  return  len;
+}
+
+//  Read the checkpoint at path into state.  Return false if there is none.
+bool checkpoint_read( const char* path, const char* config, checkpoint_state* state ){
+  FILE* file=  fopen( path, "r" );
+  if(  !file  )   return  false;
+  size_t configLen=  strlen( config );
+  char header[sizeof CHECKPOINT_HEADER],  savedConfig[configLen + 2];
+  bool ok=  fgets( header, sizeof header, file )  &&  !strcmp( header, CHECKPOINT_HEADER )
+    &&      fgets( savedConfig, sizeof savedConfig, file )
+    &&      !strncmp( savedConfig, config, configLen )  &&  savedConfig[configLen] == '\n'
+    &&      fscanf( file, "%u", &state->next ) == 1;
+  for(  uint m= 0;  ok  &&  m < methodsUsedN;  ++m  ){
+    ok=  fscanf( file, "%u %u %u %u", &state->model1_favors1[m], &state->model2_favors1[m],
+                                    &state->model1_failed[m],  &state->model2_failed[m] ) == 4;
+  }
+  ok=  ok  &&  fgetc( file ) == '\n'  &&  fgetc( file ) == EOF;
+  fclose( file );
+  if(  !ok  ){
+    fprintf( stderr, "%s: not a checkpoint of this configuration:\n  %s\n", path, config );
+    exit( 65 );
+  }
+  return  true;
+}
+
+
+int main( int argc, char *argv[] ){
+
+  uint datasets_n= 10;
+  bool useBank= false;
+  const char* checkpointPath= NULL;
+  const char* optstring= "t:n:s:i:q:G:g:j:Q:L:a:p:R:m:e:T:bc:";
+  threadsN=  sysconf( _SC_NPROCESSORS_ONLN );
+
+  {
+    char usage_fmt[]=
+      "Usage: %s [-t num_threads] [-n data_n] [-s sample_n] [-i importance_sample_n] [-q qmc_sample_n]"
+      " [-G Gauss_grid_n] [-g gamma_grid_n] [-j JBeta_grid_n] [-Q quadrature_nodes_n] [-L sparse_grid_level]"
+      " [-a adaptive_eval_n] [-p prune_tolerance] [-R generator]"
+      " [-m methods] [-e tolerance] [-T seconds] [-b] [-c checkpoint_file] [num_datasets]\n"
+      "  -m  comma separated integration methods to compare, from:\n"
+      "      sampling,summing,importance,qmc,quadrature,sparsegrid,adaptive  (default sampling,summing)\n"
+      "  -L  sparse grid level, at most 20 (default 9)\n"
+      "  -p  relative error allowed from skipping negligible terms of Riemann sums and quadrature,\n"
+      "      0 to skip none (default 1e-6)\n"
+      "  -e  stop sampling once the estimate's relative standard error is below this, judged only after\n"
+      "      32768 samples, or a quarter of the sample count if that is smaller\n"
+      "  -T  stop sampling after this many seconds per integral; results then vary with timing\n"
+      "  -R  random number generator, mt19937 (default) or philox\n"
+      "  -b  draw one bank of prior samples and share it among all datasets\n"
+      "  -c  save progress to this file after each dataset, and resume from it if it exists\n";
+    methods_select( "sampling,summing" );
+    int opt;
+    while(  (opt= getopt( argc, argv, optstring )) != -1  ){
+      uint* target;
+      switch( opt ){
+      case 'b':  useBank= true;  continue;
+      case 'c':  checkpointPath= optarg;  continue;
+      case 'm':
+        if(  !methods_select( optarg )  ){
+          printf(  usage_fmt, argv[0]  );
+          exit( 64 );
+        }
+        continue;
+      case 'e':
+      case 'T':
+        *(opt == 'e'?  &sampleTolerance : &sampleTimeBudget)=  atof( optarg );
+        if(  !(atof( optarg ) > 0.0)  ){
+          printf(  usage_fmt, argv[0]  );
+          exit( 64 );
+        }
+        continue;
+      case 'R':
+        if(  !GSLfun_select_generator( optarg )  ){
+          printf(  usage_fmt, argv[0]  );
+          exit( 64 );
+        }
+        continue;
+      case 'p':
+        pruneTolerance=  atof( optarg );
+        if(  !(pruneTolerance >= 0.0  &&  pruneTolerance < 1.0)  ){
+          printf(  usage_fmt, argv[0]  );
+          exit( 64 );
+        }
+        continue;
+      case 'i':  target= &importanceSampleNum;  break;
+      case 'q':  target= &qmcSampleNum;         break;
+      case 't':  target= &threadsN;         break;
+      case 'n':  target= &dataN;            break;
+      case 's':  target= &sampleRepeatNum;  break;
+      case 'G':  target= &cdf_Gauss_n;      break;
+      case 'g':  target= &cdf_gamma_n;      break;
+      case 'j':  target= &cdf_JBeta_n;      break;
+      case 'Q':  target= &quad_nodes_n;     break;
+      case 'L':  target= &smolyakLevel;     break;
+      case 'a':  target= &adaptiveEvalNum;  break;
+      default:
+        printf(  usage_fmt, argv[0]  );
+        exit( 64 );
+      }
+      *target=  atoi( optarg );
+      if(  !*target  ||  smolyakLevel > 20  ){
+        printf(  usage_fmt, argv[0]  );
+        exit( 64 );
+      }
+    }
+    switch( argc - optind ){
+    case 0:
+      break;
+    case 1:
+      datasets_n=  atoi( argv[optind] );
+      if( !datasets_n ){
+        printf(  usage_fmt, argv[0]  );
+        exit( 64 );
+      }
+      break;
+    default:
+      printf(  usage_fmt, argv[0]  );
+      exit( 64 );
+    }
+  }
+
+  GSLfun_setup();
+  cdfInv_precompute();
+#ifndef NDEBUG
+  self_checks();
+#endif
+  if(  useBank  )   priorBank=  prior_sample_bank_alloc( sampleRepeatNum );
+
+  // For each method in use, the number of datasets on which it favors the pooled model
+  checkpoint_state progress=  {0};
+  uint* model1_favors1=  progress.model1_favors1;
+  uint* model2_favors1=  progress.model2_favors1;
+  uint* model1_failed=  progress.model1_failed;   // and the number on which it failed, left out of the counts
+  uint* model2_failed=  progress.model2_failed;
+
+  // The configuration a checkpoint must match:  seed, generator and arguments, leaving out the checkpoint file
+  // and the number of threads, on which results do not depend
+  char config[4096];
+  int configLen=  snprintf(  config, sizeof config, "seed=%lu generator=%s args:",
+                             gsl_rng_default_seed, gsl_rng_name( GSLfun_RNG_global() )  );
+  config_append_args( config, sizeof config, configLen, argc, argv, optstring, "ct" );
+  if(  checkpointPath  &&  checkpoint_read( checkpointPath, config, &progress )  ){
+    printf(  "Resuming from checkpoint %s, after %u of %u datasets\n", checkpointPath, progress.next, 2 * datasets_n  );
+  }
+
+
+  // Evaluate datasets on up to threadsN threads, each dataset's integrators sharing what is left over.
+  dataset_job job=  {datasets_n,  2 * datasets_n,  progress.next,
+                     malloc( 2 * datasets_n * sizeof(dataset_result) ),
+                     calloc( 2 * datasets_n, sizeof(bool) ),
+                     PTHREAD_MUTEX_INITIALIZER,  PTHREAD_COND_INITIALIZER};
+  uint workersN=  (threadsN < job.tasks_n)?  threadsN : job.tasks_n;
+  integratorThreadsN=  threadsN / workersN;
+  pthread_t workers[workersN];
+  for(  uint w= 0;  w < workersN;  ++w  ){
+    if(  pthread_create( &workers[w], NULL, dataset_worker, &job )  ){
+      perror( "pthread_create" );
+      exit( 71 );
+    }
+  }
+
+
+
+  printf(  "Starting computation for %d datasets each. ...\n",  datasets_n  );
+
+  if(  progress.next < datasets_n  )   printf( "\nData generated with one component\n" );
+  for(  uint iter= progress.next;  iter < datasets_n;  ++iter  ){
+    const dataset_result* result=  dataset_result_wait( &job, iter );
+    Gauss_params model_params = result->model_params.Gauss1;
+    printf(  "generating data with: (μ,σ) =  (%4.2f,%4.2f)\n", model_params.mu, model_params.sigma  );
+    dataset_result_print( result, model1_favors1, model1_failed );
+    progress.next=  iter + 1;
+    if(  checkpointPath  )   checkpoint_write( checkpointPath, config, &progress );
+  }
+
+
+  if(  progress.next < 2 * datasets_n  )   printf( "\nData generated with two components\n" );
+  for(  uint iter= progress.next - datasets_n;  iter < datasets_n;  ++iter  ){
+    const dataset_result* result=  dataset_result_wait( &job, datasets_n + iter );
+    Gauss_mixture_params model_params=  result->model_params;
+    printf(  "generating data with:  m; (μ1,σ1); (μ2,σ2) =  %5.3f; (%4.2f,%4.2f); (%4.2f,%4.2f)\n",
+             model_params.mixCof,
+             model_params.Gauss1.mu, model_params.Gauss1.sigma,
+             model_params.Gauss2.mu, model_params.Gauss2.sigma  );
+    dataset_result_print( result, model2_favors1, model2_failed );
+    progress.next=  datasets_n + iter + 1;
+    if(  checkpointPath  )   checkpoint_write( checkpointPath, config, &progress );
+  }
+
+  for(  uint w= 0;  w < workersN;  ++w  ){
+    pthread_join( workers[w], NULL );
+  }
+  free( job.results );
+  free( job.done );
+  if(  priorBank  )   prior_sample_bank_free( priorBank );
+  prior_rule_free( &quantileRule );
+
+  for(  uint m= 0;  m < methodsUsedN;  ++m  ){
+    uint model1_n=  datasets_n - model1_failed[m],  model2_n=  datasets_n - model2_failed[m];
+    printf(  "By %-10s Model1 data, correct selection %u/%u", methods[methodsUsed[m]].name, model1_favors1[m], model1_n  );
+    if(  model1_failed[m]  )   printf( ", failed on %u", model1_failed[m] );
+    printf(  "\n   %-10s Model2 data, correct selection %u/%u", "", (model2_n - model2_favors1[m]), model2_n  );
+    if(  model2_failed[m]  )   printf( ", failed on %u", model2_failed[m] );
+    printf( "\n" );
+  }
 }